@@ -40,6 +40,7 @@ extern "C" {
 }
 
 #include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/http/response.hpp>
 #include <mosh/cgi/html/element.hpp>
 #include <mosh/cgi/html/element/s.hpp>
 
@@ -81,44 +82,46 @@ int main() {
 	gettimeofday(&start, NULL);
 	string name;
 	string value;
+	// The page is buffered, and sent with its length once complete
+	Response r(cout);
 	// Output the headers for an HTML document with the cookie only
 	// if the cookie is not empty
 	{
 		header::Header h = header::status(420) + header::content_type("text/xhtml+xml");
 		if (name != "" && value != "")
 			h += header::P(name, value);
-		cout << h;
+		r.header += h;
 	}
 	// Output the HTML 4.0 DTD info
-	cout << s::html_begin()({
+	r << s::html_begin()({
 		s::P("lang", "en"),
 		s::P("dir", "ltr")
 	});
 	// Set up the page's header and title.
-	cout << s::head( {
+	r << s::head( {
 		s::style(s::P("type", "text/css"), styles),
 		s::title("mosh-cgi cookie")
 	});
-	cout << s::body_begin();
-	cout << s::h1(S("mosh") + s::span(s::P("class", "red"), "-cgi"))
+	r << s::body_begin();
+	r << s::h1(S("mosh") + s::span(s::P("class", "red"), "-cgi"))
 		+ S("HTTP Cookies Test Results");
-	cout << s::comment("This page generated by mosh-cgi for $ENV[HTTP_REMOTE_HOST]");
-	cout << s::h4(S("Thanks for using mosh") + s::span(s::P("class", "red"), "-cgi")) + S(" $ENV[HTTP_REMOTE_HOST]($ENV[HTTP_REMOTE_ADDR])!");
+	r << s::comment("This page generated by mosh-cgi for $ENV[HTTP_REMOTE_HOST]");
+	r << s::h4(S("Thanks for using mosh") + s::span(s::P("class", "red"), "-cgi")) + S(" $ENV[HTTP_REMOTE_HOST]($ENV[HTTP_REMOTE_ADDR])!");
 	if (name != "" && value != "")
-		cout << s::p({ "A cookie with the name ", s::em(name), " and value ", s::em(value), "was set. ", s::br,
+		r << s::p({ "A cookie with the name ", s::em(name), " and value ", s::em(value), "was set. ", s::br,
 					   "In order for the cookie to show up here you must ",
 					   s::a(s::P("href", "$ENV[HTTP_SCRIPT_NAME]"), "refresh")
 			});
 	// Show the cookie info from the environment
-	cout << s::h2("Cookie Information from the Environment");
-	cout << s::div(s::P("align", "center"),
+	r << s::h2("Cookie Information from the Environment");
+	r << s::div(s::P("align", "center"),
 	s::table(s::tr({
 		s::td(s::P("class", "title"), "cookie"),
 		s::td(s::P("class", "data"), "$ENV[HTTP_COOKIE]")
 	})));
 #if 0
 	// Show the cookie info from the cookie list
-	cout << h2("HTTP Cookies via vector") << endl;
+	r << h2("HTTP Cookies via vector") << endl;
 	
 	{
 		s::Element _t = s::table();
@@ -138,14 +141,14 @@ int main() {
 				});
 		}
 	}
-	cout << s::div(_t);
+	r << s::div(_t);
 #endif
 
 	
 	// Print out the form to do it again
-	cout << s::br << endl;
+	r << s::br << endl;
 	printForm();
-	cout << s::hr(s::P("class", "half")) << endl;
+	r << s::hr(s::P("class", "half")) << endl;
 
 	
 	// Information on this query
@@ -158,8 +161,9 @@ int main() {
 		ss << setw(6) << setfill('0') << (end.tv_usec - start.tv_usec) << " us";
 		_s = ss.str();
 	}
-	cout << s::p("Total time for request = " + _s);
-	cout << s::body_end();
-	cout << s::html_end();
-	cout << endl;
+	r << s::p("Total time for request = " + _s);
+	r << s::body_end();
+	r << s::html_end();
+	r << endl;
+	r.finish();
 }
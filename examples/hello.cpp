@@ -0,0 +1,40 @@
+/*!  @file examples/hello.cpp
+ *   @brief A minimal page, for measuring process startup.
+ */
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <iostream>
+
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/html/element.hpp>
+#include <mosh/cgi/html/element/s.hpp>
+#include <mosh/cgi/html/element/ws.hpp>
+
+using namespace std;
+using namespace MOSH_CGI;
+using namespace MOSH_CGI::html::element;
+
+int main() {
+	const string header = http::header::content_type("text/html");
+	cout << header;
+	cout << s::html_begin(html::html_doctype::html_revision::html_5);
+	cout << s::head(s::title("hello"));
+	cout << s::body_begin() << s::p("Hello, world") << s::body_end();
+	cout << s::html_end() << endl;
+}
@@ -0,0 +1,57 @@
+/*!  @file examples/one_write.cpp
+ *   @brief Send a complete response in a single system call.
+ *
+ *   Usage: one_write [rows]
+ *
+ *   Builds a page with a cookie in an http::Response on standard output and
+ *   sends it. The header block and body leave together in one writev(2), which
+ *   `make trace' checks with strace.
+ */
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstdlib>
+#include <string>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <mosh/cgi/http/cookie.hpp>
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/http/response.hpp>
+#include <mosh/cgi/html/element.hpp>
+#include <mosh/cgi/html/element/s.hpp>
+
+using namespace std;
+using namespace MOSH_CGI;
+using namespace MOSH_CGI::html::element;
+
+int main(int argc, char** argv) {
+	const int rows = (argc > 1) ? atoi(argv[1]) : 20;
+	http::Response r(STDOUT_FILENO);
+	r.header += http::header::content_type("text/html");
+	r.header.cookies["session"].push_back(http::Cookie("session", "0123456789abcdef"));
+	r << s::html_begin(html::html_doctype::html_revision::html_5);
+	r << s::head(s::title("one_write")) << s::body_begin();
+	s::Element list = s::ul();
+	for (int i = 0; i < rows; ++i)
+		list += s::li("row " + to_string(i));
+	r << list << s::body_end() << s::html_end();
+	return r.finish() ? 0 : 1;
+}
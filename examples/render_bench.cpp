@@ -0,0 +1,277 @@
+/*!  @file examples/render_bench.cpp
+ *   @brief Measure element rendering throughput.
+ *
+ *   Usage: render_bench [rows [iterations]]
+ *
+ *   Renders a page holding a table of the given number of rows, the given number
+ *   of times, for both char and wchar_t, and reports the throughput.
+ */
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+extern "C" {
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+}
+
+#include <mosh/cgi/html/element.hpp>
+#include <mosh/cgi/html/static_element.hpp>
+#include <mosh/cgi/html/element/s.hpp>
+#include <mosh/cgi/html/element/ws.hpp>
+#include <mosh/cgi/http/deflate_filter.hpp>
+#include <mosh/cgi/http/etag.hpp>
+#include <mosh/cgi/http/response.hpp>
+#include <mosh/cgi/html/mapped_text.hpp>
+#include <mosh/cgi/bits/utf8.hpp>
+#include <mosh/cgi/bits/cpu.hpp>
+
+using namespace std;
+using namespace MOSH_CGI;
+using namespace MOSH_CGI::html::element;
+
+namespace {
+
+double now_s() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+template <typename charT>
+basic_string<charT> widen(const string& s) {
+	return basic_string<charT>(s.begin(), s.end());
+}
+
+// A table of n rows of three cells each
+template <typename charT, typename Catalog>
+typename Catalog::Element make_table(const Catalog& c, int n) {
+	typedef basic_string<charT> string;
+	typename Catalog::Element table = c.table({ attr::class_(widen<charT>("list")) });
+	for (int i = 0; i < n; ++i) {
+		string row = c.tr({
+			c.td(widen<charT>(to_string(i))),
+			c.td({ attr::class_(widen<charT>("name")) }, widen<charT>("item")),
+			c.td(c.a({ attr::href(widen<charT>("/item/" + to_string(i))) },
+				widen<charT>("view")))
+		});
+		table += row;
+	}
+	return table;
+}
+
+// One page, around the table
+template <typename charT, typename Catalog>
+size_t render(const Catalog& c, int n) {
+	basic_ostringstream<charT> os;
+	os << typename Catalog::html_begin(html::html_doctype::html_revision::html_5);
+	os << c.head(c.title(widen<charT>("render_bench")));
+	os << typename Catalog::body_begin();
+	os << make_table<charT>(c, n) << typename Catalog::body_end() << typename Catalog::html_end();
+	return os.str().size();
+}
+
+template <typename charT, typename Catalog>
+void run(const char* what, const Catalog& c, int rows, int iterations) {
+	size_t chars = 0;
+	double start = now_s();
+	for (int i = 0; i < iterations; ++i)
+		chars += render<charT>(c, rows);
+	double t = now_s() - start;
+	printf("%-9s %d x %d rows: %.3f s  %.1f Mchar/s  %.0f ns/element\n", what, iterations, rows,
+		t, chars / t / 1e6, t * 1e9 / (iterations * (rows * 5.0 + 1)));
+}
+
+// A wide table written out as UTF-8: rendered wide and transcoded, or encoded directly
+template <typename Element>
+void run_utf8(const char* what, const Element& table, int rows, int iterations, bool direct) {
+	size_t bytes = 0;
+	double start = now_s();
+	for (int i = 0; i < iterations; ++i) {
+		string out;
+		if (direct) {
+			table.append_utf8(out);
+		} else {
+			const wstring w = table;
+			utf8::append(out, w);
+		}
+		bytes += out.size();
+	}
+	double t = now_s() - start;
+	printf("%-9s %d x %d rows: %.3f s  %.1f MB/s\n", what, iterations, rows, t, bytes / t / 1e6);
+}
+
+// A rendered page, compressed as a response body would be
+void run_deflate(const char* what, const string& page, int level, int iterations) {
+	size_t out = 0;
+	double start = now_s();
+	for (int i = 0; i < iterations; ++i) {
+		stringbuf sb;
+		http::Deflate_filter z(&sb, http::Coding::gzip, level);
+		z.sputn(page.data(), page.size());
+		z.finish();
+		out = z.bytes_out();
+	}
+	double t = now_s() - start;
+	printf("%-9s %d x %zu bytes: %.3f s  %.1f MB/s  ratio %.3f\n", what, iterations, page.size(),
+		t, page.size() * iterations / t / 1e6, double(out) / page.size());
+}
+
+// The same page, from a fragment compressed beforehand and a little dynamic content
+void run_splice(const char* what, const string& page, int iterations) {
+	const http::Deflated_fragment fragment(page);
+	size_t out = 0;
+	double start = now_s();
+	for (int i = 0; i < iterations; ++i) {
+		stringbuf sb;
+		http::Deflate_filter z(&sb, http::Coding::gzip);
+		ostream os(&z);
+		os << "<p>Rendered for request " << i << "</p>\n" << fragment;
+		z.finish();
+		out = z.bytes_out();
+	}
+	double t = now_s() - start;
+	printf("%-9s %d x %zu bytes: %.3f s  %.1f MB/s  ratio %.3f\n", what, iterations, page.size(),
+		t, page.size() * iterations / t / 1e6, double(out) / page.size());
+}
+
+// A rendered page, collected and tagged as for a conditional response
+void run_etag(const char* what, const string& page, int iterations) {
+	string tag;
+	double start = now_s();
+	for (int i = 0; i < iterations; ++i) {
+		http::Etag_buffer b;
+		b.sputn(page.data(), page.size());
+		tag = b.etag();
+	}
+	double t = now_s() - start;
+	printf("%-9s %d x %zu bytes: %.3f s  %.1f MB/s  %s\n", what, iterations, page.size(),
+		t, page.size() * iterations / t / 1e6, tag.c_str());
+}
+
+// A page around a large static chunk, sent to /dev/null: copied into the body, or mapped
+void run_mapped(const char* what, const string& chunk, int iterations, bool mapped) {
+	const string path = "/tmp/render_bench.css";
+	ofstream(path.c_str()) << chunk;
+	const int fd = open("/dev/null", O_WRONLY);
+	http::Response r(fd);
+	double start = now_s();
+	for (int i = 0; i < iterations; ++i) {
+		r.header += http::header::content_type("text/html");
+		r << "<style type=\"text/css\">";
+		if (mapped)
+			r << html::Mapped_text(path);
+		else
+			r << chunk;
+		r << "</style>";
+		r.reset();
+	}
+	double t = now_s() - start;
+	close(fd);
+	unlink(path.c_str());
+	printf("%-9s %d x %zu bytes: %.3f s  %.1f MB/s\n", what, iterations, chunk.size(),
+		t, chunk.size() * iterations / t / 1e6);
+}
+
+struct Narrow {
+	typedef s::Element Element;
+	const s::Element_prototype& table;
+	const s::Element_prototype& tr;
+	const s::Element_prototype& td;
+	const s::Element_prototype& a;
+	const s::Element_prototype& head;
+	const s::Element_prototype& title;
+	typedef s::html_begin html_begin;
+	typedef s::html_end html_end;
+	typedef s::body_begin body_begin;
+	typedef s::body_end body_end;
+};
+
+struct Wide {
+	typedef ws::Element Element;
+	const ws::Element_prototype& table;
+	const ws::Element_prototype& tr;
+	const ws::Element_prototype& td;
+	const ws::Element_prototype& a;
+	const ws::Element_prototype& head;
+	const ws::Element_prototype& title;
+	typedef ws::html_begin html_begin;
+	typedef ws::html_end html_end;
+	typedef ws::body_begin body_begin;
+	typedef ws::body_end body_end;
+};
+
+struct Narrow_static {
+	typedef Static_element<char> Element;
+	Element table;
+	Element tr;
+	Element td;
+	Element a;
+	Element head;
+	Element title;
+	typedef Static_HTML_begin<char> html_begin;
+	typedef s::html_end html_end;
+	typedef Static_body_begin<char> body_begin;
+	typedef s::body_end body_end;
+};
+
+struct Wide_static {
+	typedef Static_element<wchar_t> Element;
+	Element table;
+	Element tr;
+	Element td;
+	Element a;
+	Element head;
+	Element title;
+	typedef Static_HTML_begin<wchar_t> html_begin;
+	typedef ws::html_end html_end;
+	typedef Static_body_begin<wchar_t> body_begin;
+	typedef ws::body_end body_end;
+};
+
+}
+
+int main(int argc, char** argv) {
+	int rows = (argc > 1) ? atoi(argv[1]) : 1000;
+	int iterations = (argc > 2) ? atoi(argv[2]) : 100;
+	// Set MOSH_CGI_CPU to generic, sse2 or avx2 to compare kernels
+	printf("kernels: %s (cpu: %s)\n", cpu::name(cpu::level()), cpu::name(cpu::detected()));
+	run<char>("char", Narrow { s::table, s::tr, s::td, s::a, s::head, s::title }, rows, iterations);
+	run<wchar_t>("wchar_t", Wide { ws::table, ws::tr, ws::td, ws::a, ws::head, ws::title }, rows, iterations);
+	run<char>("char s", Narrow_static { s::table, s::tr, s::td, s::a, s::head, s::title }, rows, iterations);
+	run<wchar_t>("wchar_t s", Wide_static { ws::table, ws::tr, ws::td, ws::a, ws::head, ws::title }, rows, iterations);
+	const Wide_static::Element table = make_table<wchar_t>(
+		Wide_static { ws::table, ws::tr, ws::td, ws::a, ws::head, ws::title }, rows);
+	run_utf8("utf8 via w", table, rows, iterations * 10, false);
+	run_utf8("utf8", table, rows, iterations * 10, true);
+	string page;
+	table.append_utf8(page);
+	run_deflate("gzip -1", page, http::Deflate_level::fastest, iterations);
+	run_deflate("gzip", page, http::Deflate_level::standard, iterations);
+	run_deflate("gzip -9", page, http::Deflate_level::best, iterations);
+	run_splice("gzip frag", page, iterations * 10);
+	run_etag("etag", page, iterations * 10);
+	run_mapped("copied", page, iterations * 10, false);
+	run_mapped("mapped", page, iterations * 10, true);
+}
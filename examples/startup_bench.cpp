@@ -0,0 +1,129 @@
+/*!  @file examples/startup_bench.cpp
+ *   @brief Measure process startup of a CGI program.
+ *
+ *   Usage: startup_bench N program [args...]
+ *
+ *   Runs the program N times, the way a web server runs a CGI program: a fresh
+ *   process each time, with its standard output on a pipe. Reports the
+ *   distribution of the time until the first byte of output arrives, and of
+ *   the time until the program has exited.
+ */
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+}
+
+using namespace std;
+
+namespace {
+
+double now_us() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+struct Sample {
+	double first_byte;
+	double exit;
+};
+
+// Run argv once with stdout on a pipe; times are in us since fork
+Sample run_once(char** argv) {
+	int fds[2];
+	if (pipe(fds) < 0) {
+		perror("pipe");
+		exit(1);
+	}
+	double start = now_us();
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		exit(1);
+	}
+	if (pid == 0) {
+		close(fds[0]);
+		dup2(fds[1], 1);
+		close(fds[1]);
+		execv(argv[0], argv);
+		_exit(127);
+	}
+	close(fds[1]);
+	Sample r;
+	char buf[65536];
+	ssize_t n = read(fds[0], buf, sizeof(buf));
+	r.first_byte = now_us() - start;
+	while (n > 0)
+		n = read(fds[0], buf, sizeof(buf));
+	close(fds[0]);
+	int status;
+	waitpid(pid, &status, 0);
+	r.exit = now_us() - start;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		fprintf(stderr, "%s failed\n", argv[0]);
+		exit(1);
+	}
+	return r;
+}
+
+double percentile(const vector<double>& t, double p) {
+	size_t i = static_cast<size_t>(p / 100 * (t.size() - 1) + 0.5);
+	return t[i];
+}
+
+void report(const char* what, vector<double>& t) {
+	sort(t.begin(), t.end());
+	double sum = 0;
+	for (double x : t)
+		sum += x;
+	printf("%-11s min %8.1f  p50 %8.1f  p90 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f  mean %8.1f\n",
+		what, t.front(), percentile(t, 50), percentile(t, 90), percentile(t, 99),
+		percentile(t, 99.9), t.back(), sum / t.size());
+}
+
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3 || atoi(argv[1]) < 1) {
+		fprintf(stderr, "usage: %s N program [args...]\n", argv[0]);
+		return 2;
+	}
+	int n = atoi(argv[1]);
+	vector<double> first_byte, done;
+	first_byte.reserve(n);
+	done.reserve(n);
+	// One untimed run to warm the page cache
+	run_once(argv + 2);
+	for (int i = 0; i < n; ++i) {
+		Sample s = run_once(argv + 2);
+		first_byte.push_back(s.first_byte);
+		done.push_back(s.exit);
+	}
+	printf("%d runs of %s (us)\n", n, argv[2]);
+	report("first byte", first_byte);
+	report("exit", done);
+}
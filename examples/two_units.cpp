@@ -0,0 +1,38 @@
+/*!  @file examples/two_units.cpp
+ *   @brief Link check: the public headers in more than one translation unit.
+ *
+ *   Usage: two_units
+ *
+ *   This and two_units_b.cpp include every public header and use the catalog
+ *   helpers. It only has to link; it prints what both units render.
+ */
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <iostream>
+#include <string>
+#include "two_units.h"
+
+using namespace MOSH_CGI;
+using namespace MOSH_CGI::html::element;
+
+int main() {
+	const std::string first = s::p(s::P("class", "first"), "one");
+	std::cout << first << second_unit() << std::endl;
+	return 0;
+}
@@ -0,0 +1,71 @@
+/*!  @file examples/two_units.h
+ *   @brief Every public header, for the two-unit link check.
+ *
+ *   two_units.cpp and two_units_b.cpp both include this, so that a definition
+ *   in a header which is not inline, and so is defined in both units, fails
+ *   the link of `make examples'.
+ */
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef TWO_UNITS_H
+#define TWO_UNITS_H 1
+
+#include <string>
+
+#include <mosh/cgi/bits/ci_strcomp.hpp>
+#include <mosh/cgi/bits/cpu.hpp>
+#include <mosh/cgi/bits/fd_io.hpp>
+#include <mosh/cgi/bits/indices.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/t_string.hpp>
+#include <mosh/cgi/bits/utf8.hpp>
+#include <mosh/cgi/bits/xxh64.hpp>
+#include <mosh/cgi/html/element.hpp>
+#include <mosh/cgi/html/element/attr.hpp>
+#include <mosh/cgi/html/element/registry.hpp>
+#include <mosh/cgi/html/element/s.hpp>
+#include <mosh/cgi/html/element/ws.hpp>
+#include <mosh/cgi/html/escape.hpp>
+#include <mosh/cgi/html/html_doctype.hpp>
+#include <mosh/cgi/html/mapped_text.hpp>
+#include <mosh/cgi/html/sgml_doctype.hpp>
+#include <mosh/cgi/html/static_element.hpp>
+#include <mosh/cgi/html/xml_declaration.hpp>
+#include <mosh/cgi/http/conditional.hpp>
+#include <mosh/cgi/http/cookie.hpp>
+#include <mosh/cgi/http/deflate_filter.hpp>
+#include <mosh/cgi/http/etag.hpp>
+#include <mosh/cgi/http/field_map.hpp>
+#include <mosh/cgi/http/file_body.hpp>
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/http/helpers/content_type.hpp>
+#include <mosh/cgi/http/helpers/helper.hpp>
+#include <mosh/cgi/http/helpers/redirect.hpp>
+#include <mosh/cgi/http/helpers/response.hpp>
+#include <mosh/cgi/http/helpers/status.hpp>
+#include <mosh/cgi/http/helpers/status_helper.hpp>
+#include <mosh/cgi/http/misc.hpp>
+#include <mosh/cgi/http/range.hpp>
+#include <mosh/cgi/http/response.hpp>
+#include <mosh/cgi/http/utf8_filter.hpp>
+
+//! Renders a little, from the second unit
+std::string second_unit();
+
+#endif
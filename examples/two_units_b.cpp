@@ -0,0 +1,32 @@
+/*!  @file examples/two_units_b.cpp
+ *   @brief Second translation unit of the two_units link check.
+ */
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <string>
+#include "two_units.h"
+
+using namespace MOSH_CGI;
+using namespace MOSH_CGI::html::element;
+
+std::string second_unit() {
+	const std::string narrow = s::p(s::P("class", "second"), "two");
+	const std::wstring wide = ws::p(ws::P("class", L"wide"), L"three");
+	return narrow + std::string(wide.begin(), wide.end());
+}
@@ -30,8 +30,8 @@
 MOSH_CGI_BEGIN
 
 template <typename char_type> char_type _xlower(const char_type&);
-template<> char _xlower<char>(const char& ch) { return std::tolower(ch); }
-template<> wchar_t _xlower<wchar_t>(const wchar_t& wc) { return std::towlower(wc); }
+template<> inline char _xlower<char>(const char& ch) { return std::tolower(ch); }
+template<> inline wchar_t _xlower<wchar_t>(const wchar_t& wc) { return std::towlower(wc); }
 
 /*!
  * @brief Compare two strings for equality, ignoring case.
@@ -0,0 +1,97 @@
+//! @file mosh/cgi/bits/cpu.hpp Runtime CPU feature dispatch
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_CPU_HPP
+#define MOSH_CGI_CPU_HPP
+
+#include <mosh/cgi/bits/namespace.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+//! Defined where x86 kernels are built, each for its own target
+#  define MOSH_CGI_X86_KERNELS 1
+//! Build a function for an instruction set extension, e.g. MOSH_CGI_TARGET("avx2")
+#  define MOSH_CGI_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+MOSH_CGI_BEGIN
+
+/*! @brief CPU feature dispatch
+ * Kernels which have vectorized implementations keep one per level, all in the
+ * same build, and pick one on first use with select(). The pick is cached by the
+ * caller, typically in a function-local static:
+ * @code
+ * static const skip_fn skip = cpu::select<skip_fn>(skip_generic, skip_sse2, skip_avx2);
+ * @endcode
+ */
+namespace cpu {
+
+//! Portable C++
+const unsigned generic = 0;
+//! x86 SSE2
+const unsigned sse2 = 1;
+//! x86 AVX2
+const unsigned avx2 = 2;
+//! Number of levels
+const unsigned n_levels = 3;
+
+/*! @brief Level which kernels run at
+ *  The best level this CPU supports, detected on first call. If the environment
+ *  variable MOSH_CGI_CPU names a level ("generic", "sse2" or "avx2"), that
+ *  level is used instead, so that each path can be forced in tests and
+ *  benchmarks; a level the CPU lacks cannot be forced, and the detected one is
+ *  used then.
+ */
+unsigned level();
+
+/*! @brief Best level this CPU supports, regardless of MOSH_CGI_CPU
+ */
+unsigned detected();
+
+/*! @brief Get the name of a level
+ *  @param[in] l level
+ *  @return the name, or "unknown"
+ */
+const char* name(unsigned l);
+
+/*! @brief Get a level by name
+ *  @param[in] s name, as returned by name()
+ *  @return the level, or n_levels if s is not a level
+ */
+unsigned parse(const char* s);
+
+/*! @brief Pick a kernel
+ *  @param[in] g portable implementation
+ *  @param[in] s SSE2 implementation, if any
+ *  @param[in] a AVX2 implementation, if any
+ *  @return the implementation for the highest level up to level() which has one
+ */
+template <typename F>
+F select(F g, F s = nullptr, F a = nullptr) {
+	const unsigned l = level();
+	if (l >= avx2 && a != nullptr)
+		return a;
+	if (l >= sse2 && s != nullptr)
+		return s;
+	return g;
+}
+
+}
+
+MOSH_CGI_END
+
+#endif
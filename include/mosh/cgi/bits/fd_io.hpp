@@ -0,0 +1,87 @@
+//! @file mosh/cgi/bits/fd_io.hpp File descriptor output
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_FD_IO_HPP
+#define MOSH_CGI_FD_IO_HPP
+
+#include <cstddef>
+#include <streambuf>
+#include <mosh/cgi/bits/namespace.hpp>
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/uio.h>
+}
+
+MOSH_CGI_BEGIN
+
+/*! @brief Output to file descriptors
+ * The functions here write everything they are given: they carry on after a short
+ * write or EINTR, and wait for a non-blocking descriptor to become writable.
+ * They return false on any other error, with errno set.
+ */
+namespace fd_io {
+
+/*! @brief Write blocks, as with writev(2)
+ *  Blocks of length 0 are skipped; there is no system call if all are empty.
+ *  @param[in] fd file descriptor
+ *  @param[in,out] v blocks; changed to track progress
+ *  @param[in] n number of blocks
+ */
+bool write_all(int fd, iovec* v, int n);
+
+/*! @brief Write a block
+ *  @param[in] fd file descriptor
+ *  @param[in] p data
+ *  @param[in] n length of p
+ */
+bool write_all(int fd, const void* p, size_t n);
+
+/*! @brief Copy part of a file to a file descriptor
+ *  Uses splice(2) into a pipe and sendfile(2) into anything else, so that the data
+ *  does not pass through user space, and falls back to mapping the file and
+ *  writing it out where neither can be used.
+ *  @param[in] out file descriptor to write to
+ *  @param[in] in file to read from
+ *  @param[in] offset offset in @c in
+ *  @param[in] n number of bytes
+ */
+bool send_file(int out, int in, off_t offset, size_t n);
+
+/*! @brief Copy part of a file to a stream buffer
+ *  The file is mapped, a window at a time, and written out from the mapping.
+ *  @param[in] out buffer to write to
+ *  @param[in] in file to read from
+ *  @param[in] offset offset in @c in
+ *  @param[in] n number of bytes
+ */
+bool send_file(std::streambuf* out, int in, off_t offset, size_t n);
+
+/*! @brief Create an anonymous temporary file
+ *  The file is created in $TMPDIR, or /tmp, with O_TMPFILE where the system has
+ *  it, so that it never has a name; elsewhere it is unlinked as soon as it is
+ *  created. Either way it goes away when closed.
+ *  @return file descriptor open for reading and writing, or -1 on failure
+ */
+int temp_file();
+
+}
+
+MOSH_CGI_END
+
+#endif
@@ -0,0 +1,39 @@
+//! @file mosh/cgi/bits/indices.hpp Compile-time index sequences
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_INDICES_HPP
+#define MOSH_CGI_INDICES_HPP
+
+#include <cstddef>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+/*! @brief A pack of indices
+ * Used to build constant tables from constexpr functions:
+ * given f(size_t), make_table(Make_indices<N>::type()) can expand to { f(I)... }.
+ */
+template <size_t... I> struct Indices { };
+
+//! Indices<0, ..., N - 1>
+template <size_t N, size_t... I> struct Make_indices : Make_indices<N - 1, N - 1, I...> { };
+template <size_t... I> struct Make_indices<0, I...> { typedef Indices<I...> type; };
+
+MOSH_CGI_END
+
+#endif
@@ -0,0 +1,119 @@
+//! @file mosh/cgi/bits/string_view.hpp Non-owning string references
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_STRING_VIEW_HPP
+#define MOSH_CGI_STRING_VIEW_HPP
+
+#include <cstddef>
+#include <string>
+#include <ostream>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+/*! @brief Non-owning reference to a character sequence
+ * Implicitly constructible from string literals, C strings and std::basic_strings,
+ * so that a single overload taking a view accepts all three without building a
+ * temporary string. A view does not own its characters; the referenced storage
+ * must outlive it.
+ */
+template <typename charT>
+class Basic_string_view {
+public:
+	typedef std::basic_string<charT> string;
+	typedef const charT* const_iterator;
+
+	//! Empty view
+	constexpr Basic_string_view()
+	: p(nullptr), n(0)
+	{ }
+
+	/*! @brief View a character sequence
+	 *  @param[in] s first character
+	 *  @param[in] size length of @c s
+	 */
+	constexpr Basic_string_view(const charT* s, size_t size)
+	: p(s), n(size)
+	{ }
+
+	/*! @brief View a NUL-terminated string
+	 *  @param[in] s string
+	 */
+	Basic_string_view(const charT* s)
+	: p(s), n(std::char_traits<charT>::length(s))
+	{ }
+
+	/*! @brief View a string
+	 *  @param[in] s string
+	 */
+	Basic_string_view(const string& s)
+	: p(s.data()), n(s.size())
+	{ }
+
+	constexpr const charT* data() const {
+		return p;
+	}
+	constexpr size_t size() const {
+		return n;
+	}
+	constexpr bool empty() const {
+		return n == 0;
+	}
+	constexpr const_iterator begin() const {
+		return p;
+	}
+	constexpr const_iterator end() const {
+		return p + n;
+	}
+	constexpr charT operator [] (size_t i) const {
+		return p[i];
+	}
+
+	//! Copy into a string
+	string str() const {
+		return string(p, n);
+	}
+
+	bool operator == (Basic_string_view v) const {
+		return n == v.n && std::char_traits<charT>::compare(p, v.p, n) == 0;
+	}
+	bool operator != (Basic_string_view v) const {
+		return !(*this == v);
+	}
+
+private:
+	const charT* p;
+	size_t n;
+};
+
+typedef Basic_string_view<char> String_view;
+typedef Basic_string_view<wchar_t> WString_view;
+
+template <typename charT>
+std::basic_string<charT>& operator += (std::basic_string<charT>& s, Basic_string_view<charT> v) {
+	return s.append(v.data(), v.size());
+}
+
+template <typename charT>
+std::basic_ostream<charT>& operator << (std::basic_ostream<charT>& os, Basic_string_view<charT> v) {
+	return os.write(v.data(), v.size());
+}
+
+MOSH_CGI_END
+
+#endif
@@ -25,21 +25,42 @@
 
 MOSH_CGI_BEGIN
 
+/*! @brief Widen a character
+ *  ASCII maps to itself in every wide execution character set the library runs on,
+ *  so only other characters go through the ctype facet of the global locale.
+ *  Nothing here touches the global locale, and no locale is looked up for ASCII.
+ */
 template <typename T>
 T wide_char(char ch) {
-	// It's a bit roundabout, but this is the only way to get the current locale
-	std::locale loc = std::locale::global(std::locale::classic());
-	std::locale::global(loc);
-	return std::use_facet<std::ctype<T>>(loc). widen(ch);
+	if (static_cast<unsigned char>(ch) < 0x80)
+		return static_cast<T>(ch);
+	return std::use_facet<std::ctype<T>>(std::locale()).widen(ch);
+}
+
+template <>
+inline char wide_char<char>(char ch) {
+	return ch;
 }
 
 template <typename T>
 std::basic_string<T> wide_string(const std::string& s) {
 	std::basic_string<T> t(s.size(), 0);
-	for (size_t i = 0; i < s.size(); ++i)
-		t[i] = wide_char<T>(s[i]);
+	size_t i = 0;
+	for (; i < s.size() && static_cast<unsigned char>(s[i]) < 0x80; ++i)
+		t[i] = static_cast<T>(s[i]);
+	if (i < s.size()) {
+		std::locale loc;
+		const std::ctype<T>& ct = std::use_facet<std::ctype<T>>(loc);
+		for (; i < s.size(); ++i)
+			t[i] = ct.widen(s[i]);
+	}
 	return t;
 }
 
+template <>
+inline std::string wide_string<char>(const std::string& s) {
+	return s;
+}
+
 MOSH_CGI_END
 #endif
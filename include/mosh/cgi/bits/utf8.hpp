@@ -0,0 +1,98 @@
+//! @file mosh/cgi/bits/utf8.hpp UTF-8 validation, repair and encoding
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_UTF8_HPP
+#define MOSH_CGI_UTF8_HPP
+
+#include <cstddef>
+#include <string>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+/*! @brief UTF-8 kernels
+ * Validity is as in RFC 3629: overlong forms, surrogates and code points above
+ * U+10FFFF are rejected. ASCII is skipped 16 or 32 bytes at a time with SSE2 or
+ * AVX2, picked at run time (see cpu::select), or eight at a time otherwise, so
+ * mostly-ASCII text validates at close to the speed of a copy.
+ */
+namespace utf8 {
+
+//! U+FFFD REPLACEMENT CHARACTER, encoded
+const char replacement[] = "\xEF\xBF\xBD";
+
+/*! @brief Length of the longest valid prefix
+ *  @param[in] s text
+ *  @param[in] n length of s
+ */
+size_t valid_prefix(const char* s, size_t n);
+
+/*! @brief Check whether text is valid UTF-8
+ *  @param[in] s text
+ *  @param[in] n length of s
+ */
+inline bool valid(const char* s, size_t n) {
+	return valid_prefix(s, n) == n;
+}
+
+/*! @brief Check whether text is the start of a valid sequence, cut short
+ *  @param[in] s text
+ *  @param[in] n length of s
+ */
+bool truncated(const char* s, size_t n);
+
+/*! @brief Append text, replacing invalid sequences with U+FFFD
+ *  Each maximal invalid subpart becomes one U+FFFD, as recommended by Unicode.
+ *  @param[in,out] out string to append to
+ *  @param[in] s text
+ *  @param[in] n length of s
+ *  @param[in] final if false, a sequence cut short at the end of s is left alone,
+ *    for the next call to complete
+ *  @return number of bytes of s consumed
+ */
+size_t repair(std::string& out, const char* s, size_t n, bool final = true);
+
+/*! @brief Append wide text, encoded as UTF-8
+ *  Where wchar_t is 32 bits wide, ASCII is narrowed 16 or 32 characters per step
+ *  with SSE2 or AVX2, or four otherwise. Characters which cannot be encoded
+ *  (lone surrogates, values above U+10FFFF) become U+FFFD; where wchar_t is
+ *  16 bits wide, surrogate pairs are combined.
+ *  @param[in,out] out string to append to
+ *  @param[in] s text
+ *  @param[in] n length of s
+ */
+void append(std::string& out, const wchar_t* s, size_t n);
+
+/*! @brief Append narrow text, which is taken to be UTF-8 already
+ *  The counterpart of the wide overload, for code generic in the character type.
+ */
+inline void append(std::string& out, const char* s, size_t n) {
+	out.append(s, n);
+}
+
+//! Append a string as UTF-8
+template <typename charT>
+void append(std::string& out, const std::basic_string<charT>& s) {
+	append(out, s.data(), s.size());
+}
+
+}
+
+MOSH_CGI_END
+
+#endif
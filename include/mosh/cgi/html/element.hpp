@@ -29,7 +29,10 @@
 #include <ostream>
 #include <type_traits>
 #include <mosh/cgi/html/html_doctype.hpp>
+#include <mosh/cgi/html/element/attr.hpp>
+#include <mosh/cgi/html/escape.hpp>
 #include <mosh/cgi/bits/t_string.hpp>
+#include <mosh/cgi/bits/utf8.hpp>
 #include <mosh/cgi/bits/namespace.hpp>
 
 MOSH_CGI_BEGIN
@@ -67,7 +70,10 @@ namespace Type {
 	}		
 }
 
-//! An HTML element
+/*! @brief An HTML element
+ * Rendering and the addition hooks are virtual. For a statically dispatched
+ * variant, see Static_element in static_element.hpp.
+ */
 template <typename charT>
 class Element  {
 public:
@@ -77,6 +83,8 @@ public:
 	typedef typename std::pair<std::string, string> attribute;
 	//! Typedef for attribute lists
 	typedef typename std::map<std::string, string> attr_list;
+	//! Typedef for attributes with a known key
+	typedef attr::Key_value<charT> key_attribute;
 private:
 	typedef Element<charT> this_type;
 public:
@@ -216,6 +224,69 @@ public:
 		e += _v;
 		return e;
 	}
+
+	/*! @brief Create a copy of @c *this with a given attribute.
+	 *  @param[in] _a attribute, e.g. attr::href("/")
+	 */
+	this_type operator () (const key_attribute& _a) const {
+		this_type e(*this);
+		e += _a;
+		return e;
+	}
+
+	/*! @brief Create a copy of @c *this with given attribute(s).
+	 *  @param[in] _a {}-list of attributes
+	 */
+	this_type operator () (std::initializer_list<key_attribute> _a) const {
+		this_type e(*this);
+		e += _a;
+		return e;
+	}
+
+	/*! @brief Create a copy of @c this with a given attribute and value.
+	 *  @param[in] _a attribute
+	 *  @param[in] _v value
+	 */
+	this_type operator () (const key_attribute& _a, const string& _v) const {
+		this_type e(*this);
+		e += _a;
+		e += _v;
+		return e;
+	}
+
+	/*! @brief Create a copy of @c this with given attribute(s) and a value.
+	 *  @param[in] _a {}-list of attributes
+	 *  @param[in] _v value
+	 */
+	this_type operator () (std::initializer_list<key_attribute> _a, const string& _v) const {
+		this_type e(*this);
+		e += _a;
+		e += _v;
+		return e;
+	}
+
+	/*! @brief Create a copy of @c *this with a given trusted, escaped or untrusted value.
+	 *  @param[in] _v value
+	 */
+	template <typename T>
+	typename std::enable_if<is_text<T, charT>::value, this_type>::type operator () (const T& _v) const {
+		this_type e(*this);
+		e += _v;
+		return e;
+	}
+
+	/*! @brief Create a copy of @c this with given attribute(s) and a trusted, escaped or untrusted value.
+	 *  @param[in] _a {}-list of attributes
+	 *  @param[in] _v value
+	 */
+	template <typename T>
+	typename std::enable_if<is_text<T, charT>::value, this_type>::type
+	operator () (std::initializer_list<key_attribute> _a, const T& _v) const {
+		this_type e(*this);
+		e += _a;
+		e += _v;
+		return e;
+	}
 	//@}
 	/*! @name Appenders
 	 */
@@ -240,6 +311,22 @@ public:
 		return *this;
 	}
 
+	/*! @brief Add an attribute.
+	 *  @param[in] _a attribute
+	 */
+	this_type& operator += (const key_attribute& _a) {
+		return *this += attribute(_a.key->name, _a.view().str());
+	}
+
+	/*! @brief Add attribute(s).
+	 * @param[in] _a {}-list of attributes
+	 */
+	this_type& operator += (std::initializer_list<key_attribute> _a) {
+		for (const auto& at : _a)
+			*this += at;
+		return *this;
+	}
+
 	/*! @brief Add a value.
 	 * @param[in] _v value
 	 */
@@ -258,6 +345,27 @@ public:
 		return *this;
 	}
 
+	/*! @brief Add a trusted literal, without scanning it.
+	 * @param[in] _v value
+	 */
+	this_type& operator += (const Trusted<charT>& _v) {
+		return *this += _v.text.str();
+	}
+
+	/*! @brief Add an escaped fragment as is.
+	 * @param[in] _v value
+	 */
+	this_type& operator += (const Escaped<charT>& _v) {
+		return *this += _v.text.str();
+	}
+
+	/*! @brief Add untrusted text, escaped for the content of this element.
+	 * @param[in] _v value
+	 */
+	this_type& operator += (const Untrusted<charT>& _v) {
+		return *this += escape(_v.text, element_context(name));
+	}
+
 	//@}
 
 	/*! @brief String cast operator
@@ -296,6 +404,39 @@ public:
 		return s.str();
 	}
 
+	/*! @brief Append the rendered element to a UTF-8 string
+	 *  Wide elements are encoded piece by piece, straight into @c out, so no
+	 *  rendering of the whole element as a wide string is made. Classes which
+	 *  override the string cast operator override this as well.
+	 *  @param[in,out] out string to append to
+	 *  @warn No escaping is done.
+	 */
+	virtual void append_utf8(std::string& out) const {
+		out += '<';
+		out += this->name;
+		for (const auto& a : this->attributes) {
+			out += ' ';
+			out += a.first;
+			out += "=\"";
+			utf8::append(out, a.second);
+			out += '"';
+		}
+		if (this->type == Type::unary) {
+			out += " /";
+		} else {
+			if (this->type == Type::binary)
+				out += '>';
+			utf8::append(out, this->data);
+			if (this->type == Type::binary) {
+				out += "</";
+				out += this->name;
+			} else if (this->type == Type::comment) {
+				out += "--";
+			}
+		}
+		out += '>';
+	}
+
 protected:
 	//! Default constructor for derived classes
 	Element()
@@ -474,6 +615,114 @@ std::basic_ostream<charT>& operator << (std::basic_ostream<charT>& os, const Ele
 	return os;
 }
 
+/*! @brief Element prototype
+ * A literal type naming an element. Prototypes are constant-initialized, so a
+ * catalog of them runs no code before @c main; the Element itself is only built
+ * when the prototype is called or converted.
+ */
+template <typename charT>
+class Element_prototype {
+public:
+	//! Typedef for the elements created
+	typedef Element<charT> element_type;
+	//! Typedef for strings
+	typedef typename element_type::string string;
+	//! Typedef for attributes
+	typedef typename element_type::attribute attribute;
+	//! Typedef for attributes with a known key
+	typedef typename element_type::key_attribute key_attribute;
+
+	/*! @brief Create a new prototype with a given name and type
+	 *  @param[in] type_ Element type
+	 *  @param[in] name_ Element name; must outlive the prototype
+	 *  @sa Type
+	 */
+	constexpr Element_prototype(unsigned type_, const char* name_)
+	: type(type_), name(name_)
+	{ }
+
+	//! Create the element
+	operator element_type () const {
+		return element_type(type, name);
+	}
+
+	//! Render the element, without attributes or data
+	operator string () const {
+		return static_cast<string>(element_type(type, name));
+	}
+
+	/*! @name Create and call
+	 * These overloads create an element and call it with the given arguments.
+	 * @sa Element
+	 */
+	//@{
+	element_type operator () () const {
+		return element_type(type, name);
+	}
+	element_type operator () (const attribute& _a) const {
+		return element_type(type, name)(_a);
+	}
+	element_type operator () (std::initializer_list<attribute> _a) const {
+		return element_type(type, name)(_a);
+	}
+	element_type operator () (const string& _v) const {
+		return element_type(type, name)(_v);
+	}
+	element_type operator () (std::initializer_list<string> _v) const {
+		return element_type(type, name)(_v);
+	}
+	element_type operator () (const attribute& _a, const string& _v) const {
+		return element_type(type, name)(_a, _v);
+	}
+	element_type operator () (const attribute& _a, std::initializer_list<string> _v) const {
+		return element_type(type, name)(_a, _v);
+	}
+	element_type operator () (std::initializer_list<attribute> _a, const string& _v) const {
+		return element_type(type, name)(_a, _v);
+	}
+	element_type operator () (std::initializer_list<attribute> _a, std::initializer_list<string> _v) const {
+		return element_type(type, name)(_a, _v);
+	}
+	element_type operator () (const key_attribute& _a) const {
+		return element_type(type, name)(_a);
+	}
+	element_type operator () (std::initializer_list<key_attribute> _a) const {
+		return element_type(type, name)(_a);
+	}
+	element_type operator () (const key_attribute& _a, const string& _v) const {
+		return element_type(type, name)(_a, _v);
+	}
+	element_type operator () (std::initializer_list<key_attribute> _a, const string& _v) const {
+		return element_type(type, name)(_a, _v);
+	}
+	template <typename T>
+	typename std::enable_if<is_text<T, charT>::value, element_type>::type operator () (const T& _v) const {
+		return element_type(type, name)(_v);
+	}
+	template <typename T>
+	typename std::enable_if<is_text<T, charT>::value, element_type>::type
+	operator () (std::initializer_list<key_attribute> _a, const T& _v) const {
+		return element_type(type, name)(_a, _v);
+	}
+	//@}
+
+	//! Append the rendered (empty) element to a UTF-8 string
+	void append_utf8(std::string& out) const {
+		element_type(type, name).append_utf8(out);
+	}
+
+	//! Element type
+	unsigned type;
+	//! Element name
+	const char* name;
+};
+
+template <typename charT>
+std::basic_ostream<charT>& operator << (std::basic_ostream<charT>& os, const Element_prototype<charT>& e) {
+	os << static_cast<std::basic_string<charT>>(e);
+	return os;
+}
+
 /*! @brief HTML begin class
  * This class outputs <!DOCTYPE ...><html ...> when cast to string.
  * @note For XHTML, it adds xmlns and <?xml ...?>
@@ -498,21 +747,18 @@ public:
 	 *  @sa doctype::HTML_revision
 	 */
 	HTML_begin(unsigned type_ = html_doctype::html_revision::xhtml_10_strict)
-	: Element<charT>(type_), doctype(html_doctype::html_doctype<charT>(type_)), xml_attributes()
-	{
-		if (is_xhtml()) {
-			this->attributes.insert(std::make_pair("xmlns", wide_string<charT>("http://www.w3.org/1999/xhtml")));
-		}
-	}
+	: Element<charT>(type_), prologue(&html_doctype::prologue<charT>(type_)), internal_dtd(), xml_attributes()
+	{ }
 
 	//! Copy constructor
 	HTML_begin(const HTML_begin<charT>& b)
-	: Element<charT>(b), doctype(b.doctype)
+	: Element<charT>(b), prologue(b.prologue), internal_dtd(b.internal_dtd), xml_attributes(b.xml_attributes)
 	{ }
 
 	//! Move constructor
 	HTML_begin(HTML_begin<charT>&& b)
-	: Element<charT>(std::move(b)), doctype(std::move(b.doctype))
+	: Element<charT>(std::move(b)), prologue(b.prologue), internal_dtd(std::move(b.internal_dtd)),
+	  xml_attributes(std::move(b.xml_attributes))
 	{ }
 
 	//! Destructor
@@ -611,30 +857,57 @@ public:
 		return e;
 	}
 	//@}
+	/*! @brief String cast operator
+	 *  Without added attributes or DTD, this is a copy of the cached prologue.
+	 */
 	virtual operator string () const {
-		std::basic_stringstream<charT> s;
+		if (this->attributes.empty() && this->xml_attributes.empty() && this->internal_dtd.empty())
+			return this->prologue->full;
+		string s;
 		if (is_xhtml()) {
-			s << wide_string<charT>("<?xml version=\"1\" ");
-			for (const auto& a : this->xml_attributes) {
-				s << wide_string<charT>(a.first + "=\"");
-				s << a.second + wide_string<charT>("\" ");
+			if (this->xml_attributes.empty()) {
+				s += this->prologue->xml_declaration;
+			} else {
+				s += wide_string<charT>("<?xml version=\"1.0\"");
+				for (const auto& a : this->xml_attributes) {
+					s += wide_char<charT>(' ');
+					s += wide_string<charT>(a.first);
+					s += wide_string<charT>("=\"");
+					s += a.second;
+					s += wide_char<charT>('"');
+				}
+				s += wide_string<charT>("?>");
 			}
-			s << wide_string<charT>("?>\r\n");
-		}	
-		s << this->doctype << wide_string<charT>("\r\n");
-		s << wide_string<charT>("<html");
+			s += wide_string<charT>("\r\n");
+		}
+		if (this->internal_dtd.empty()) {
+			s += this->prologue->doctype;
+		} else {
+			string d = html_doctype::html_doctype<charT>(this->type) + this->internal_dtd;
+			s += d;
+		}
+		s += wide_string<charT>("\r\n<html");
+		if (is_xhtml()) {
+			s += wide_char<charT>(' ');
+			s += this->prologue->xmlns;
+		}
 		for (const auto& a : this->attributes) {
-			s << wide_char<charT>(' ');
-			s << wide_string<charT>(a.first);
-			s << wide_char<charT>('=');
-			s << wide_char<charT>('"');
-			s << a.second;
-			s << wide_char<charT>('"');
+			s += wide_char<charT>(' ');
+			s += wide_string<charT>(a.first);
+			s += wide_char<charT>('=');
+			s += wide_char<charT>('"');
+			s += a.second;
+			s += wide_char<charT>('"');
 		}
-		s << wide_char<charT>('>');
-
-		return s.str();
+		s += wide_char<charT>('>');
+		return s;
 	}	
+
+	//! Append the rendered prologue to a UTF-8 string
+	virtual void append_utf8(std::string& out) const {
+		utf8::append(out, static_cast<string>(*this));
+	}
+
 protected:
 	virtual bool attribute_addition_hook(const attribute& _a) {
 		if (is_xhtml()) {
@@ -649,12 +922,15 @@ protected:
 		return true;
 	}
 	virtual bool data_addition_hook(const string& _s) {
-		doctype += _s;
+		internal_dtd += _s;
 		return false;
 	}
 
-	//! Doctype
-	sgml_doctype::Doctype_declaration<charT> doctype;
+	//! Cached prologue for this revision
+	const html_doctype::Prologue<charT>* prologue;
+
+	//! Internal DTD
+	string internal_dtd;
 	
 	//! List of <?xml attributes.
 	attr_list xml_attributes;
@@ -677,6 +953,11 @@ struct HTML_end {
 	virtual operator std::basic_string<charT> () const {
 		return wide_string<charT>("</html>");
 	}
+
+	//! Append </html> to a UTF-8 string
+	virtual void append_utf8(std::string& out) const {
+		out += "</html>";
+	}
 };
 
 template <typename charT>
@@ -776,6 +1057,19 @@ public:
 		return s.str();
 	}
 
+	//! Append the rendered element to a UTF-8 string
+	virtual void append_utf8(std::string& out) const {
+		out += "<body";
+		for (const auto& a : this->attributes) {
+			out += ' ';
+			out += a.first;
+			out += "=\"";
+			utf8::append(out, a.second);
+			out += '"';
+		}
+		out += '>';
+	}
+
 protected:
 	// Don't append data
 	virtual bool data_addition_hook(const string&) { return false; }
@@ -791,6 +1085,11 @@ struct Body_end {
 	virtual operator std::basic_string<charT> () const {
 		return wide_string<charT>("</body>");
 	}
+
+	//! Append </body> to a UTF-8 string
+	virtual void append_utf8(std::string& out) const {
+		out += "</body>";
+	}
 };
 
 template <typename charT>
@@ -799,9 +1098,71 @@ std::basic_ostream<charT>& operator << (std::basic_ostream<charT>& os, const Bod
 	return os;
 }
 
+//! An element to be written as UTF-8; see as_utf8()
+template <typename T>
+struct Utf8_rendering {
+	const T& e;
+};
+
+/*! @brief Write an element to a narrow stream as UTF-8
+ *  Works with any element (wide or narrow, dynamic or static) or catalog entry:
+ *  std::cout << as_utf8(ws::p(L"caf\u00e9")).
+ *  @param[in] e element, which must outlive the result
+ */
+template <typename T>
+Utf8_rendering<T> as_utf8(const T& e) {
+	return Utf8_rendering<T> { e };
+}
+
+template <typename T>
+std::ostream& operator << (std::ostream& os, const Utf8_rendering<T>& r) {
+	std::string s;
+	r.e.append_utf8(s);
+	return os.write(s.data(), s.size());
+}
+
+/*! @brief An attribute made of a literal name and value
+ * P() makes one from two literals. Added to a statically dispatched element, a
+ * known name goes in as its attr::Key with the value borrowed, so nothing is
+ * allocated; an unknown name is copied. Anywhere else, such as a dynamic
+ * Element, it converts to the usual pair.
+ */
+template <typename charT>
+struct Attribute_ref {
+	//! Attribute name
+	String_view name;
+	//! Attribute value, borrowed
+	Basic_string_view<charT> value;
+
+	//! Copy into a name/value pair
+	operator std::pair<std::string, std::basic_string<charT>> () const {
+		return std::make_pair(name.str(), value.str());
+	}
+};
+
 /*! @name Attribute taggers
  */
 //@{
+/*! @brief Attribute tagger for literals
+ *  Both are borrowed, up to their first NUL, and have to outlive the element.
+ */
+template <size_t N, typename charT, size_t M>
+Attribute_ref<charT> P(const char (&s1)[N], const charT (&s2)[M]) {
+	return Attribute_ref<charT> { String_view(s1, attr::array_length(s1)),
+		Basic_string_view<charT>(s2, attr::array_length(s2)) };
+}
+/*! @brief Attribute tagger for arrays, either of which is modifiable
+ *  A modifiable array may change or go away before the element is rendered, so
+ *  both are copied, up to their first NUL.
+ */
+template <typename Name, typename Value, size_t N, size_t M>
+typename std::enable_if<std::is_same<typename std::remove_const<Name>::type, char>::value
+	&& !(std::is_const<Name>::value && std::is_const<Value>::value),
+	std::pair<std::string, std::basic_string<typename std::remove_const<Value>::type>>>::type
+P(Name (&s1)[N], Value (&s2)[M]) {
+	return std::make_pair(std::string(s1, attr::array_length(s1)),
+		std::basic_string<typename std::remove_const<Value>::type>(s2, attr::array_length(s2)));
+}
 //! Attribute tagger. Use it to create std::pair<T1,T2>s representing element attributes.
 template <typename charT>
 std::pair<std::string, std::basic_string<charT>>
@@ -820,6 +1181,32 @@ std::basic_string<T> S(const T (&s)[N]) {
 	return std::basic_string<T>(s, N);
 }
 
+/*! @name Explicit instantiations
+ * The @c char and @c wchar_t instantiations are compiled once, into libmosh_cgi.
+ */
+//@{
+extern template class Element<char>;
+extern template class Element_prototype<char>;
+extern template class HTML_begin<char>;
+extern template class HTML_end<char>;
+extern template class Body_begin<char>;
+extern template class Body_end<char>;
+extern template class Element<wchar_t>;
+extern template class Element_prototype<wchar_t>;
+extern template class HTML_begin<wchar_t>;
+extern template class HTML_end<wchar_t>;
+extern template class Body_begin<wchar_t>;
+extern template class Body_end<wchar_t>;
+extern template std::basic_ostream<char>& operator << (std::basic_ostream<char>&, const Element<char>&);
+extern template std::basic_ostream<char>& operator << (std::basic_ostream<char>&, const Element_prototype<char>&);
+extern template std::basic_ostream<char>& operator << (std::basic_ostream<char>&, const HTML_end<char>&);
+extern template std::basic_ostream<char>& operator << (std::basic_ostream<char>&, const Body_end<char>&);
+extern template std::basic_ostream<wchar_t>& operator << (std::basic_ostream<wchar_t>&, const Element<wchar_t>&);
+extern template std::basic_ostream<wchar_t>& operator << (std::basic_ostream<wchar_t>&, const Element_prototype<wchar_t>&);
+extern template std::basic_ostream<wchar_t>& operator << (std::basic_ostream<wchar_t>&, const HTML_end<wchar_t>&);
+extern template std::basic_ostream<wchar_t>& operator << (std::basic_ostream<wchar_t>&, const Body_end<wchar_t>&);
+//@}
+
 }
 
 }
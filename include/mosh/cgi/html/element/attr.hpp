@@ -0,0 +1,434 @@
+//! @file mosh/cgi/html/element/attr.hpp Compile-time HTML attribute keys
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_HTML_ELEMENT_ATTR_HPP
+#define MOSH_CGI_HTML_ELEMENT_ATTR_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include <mosh/cgi/html/escape.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/utf8.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+namespace html {
+namespace element {
+
+/*! @brief Attribute keys
+ * Each known attribute has a constant key, e.g. attr::class_ or attr::href, which
+ * carries the pre-rendered ` name="' prefix. Calling a key with a value makes an
+ * attribute: s::a({ attr::href("/"), attr::class_("nav") }, "home").
+ *
+ * A string literal value is borrowed rather than copied, as is any value passed
+ * through Key::borrow(); the caller guarantees that it outlives the element.
+ * Other values are copied.
+ *
+ * Untrusted values (see html::untrusted()) are escaped for the key's context, so
+ * attr::href(html::untrusted(u)) percent-encodes u and refuses a javascript: URL.
+ *
+ * The keys are generated from attrs.def.
+ */
+namespace attr {
+
+//! Key ids, in the order of attrs.def
+enum Id : unsigned {
+#define MOSH_CGI_HTML_ATTR(ident_, name_, context_) id_##ident_,
+#include <mosh/cgi/html/element/attrs.def>
+#undef MOSH_CGI_HTML_ATTR
+	//! Number of known keys
+	n_keys
+};
+
+template <typename charT> struct Key_value;
+
+//! Attribute key
+struct Key {
+	//! Interned id
+	unsigned id;
+	//! Attribute name
+	const char* name;
+	//! Length of name
+	size_t size;
+	//! Pre-rendered ` name="'
+	const char* prefix;
+	//! Length of prefix
+	size_t prefix_size;
+	//! How untrusted values are escaped (one of html::Context)
+	unsigned context;
+
+	/*! @name Attribute makers
+	 */
+	//@{
+	Key_value<char> operator () (const std::string& value) const;
+	Key_value<wchar_t> operator () (const std::wstring& value) const;
+	//! String literal, or other constant array: borrowed up to its first NUL
+	template <size_t N>
+	Key_value<char> operator () (const char (&value)[N]) const;
+	//! String literal, or other constant array: borrowed up to its first NUL
+	template <size_t N>
+	Key_value<wchar_t> operator () (const wchar_t (&value)[N]) const;
+	//! Modifiable buffer: copied up to its first NUL
+	template <size_t N>
+	Key_value<char> operator () (char (&value)[N]) const;
+	//! Modifiable buffer: copied up to its first NUL
+	template <size_t N>
+	Key_value<wchar_t> operator () (wchar_t (&value)[N]) const;
+	//! Borrowed value, e.g. a cached fragment
+	Key_value<char> borrow(String_view value) const;
+	//! Borrowed value, e.g. a cached fragment
+	Key_value<wchar_t> borrow(WString_view value) const;
+	//! Trusted literal: borrowed
+	template <typename charT>
+	Key_value<charT> operator () (const Trusted<charT>& value) const;
+	//! Escaped fragment: copied as is
+	template <typename charT>
+	Key_value<charT> operator () (const Escaped<charT>& value) const;
+	//! Untrusted text: escaped for this key's context
+	template <typename charT>
+	Key_value<charT> operator () (const Untrusted<charT>& value) const;
+	//@}
+};
+
+//! An attribute with a known key
+template <typename charT>
+struct Key_value {
+	//! Key
+	const Key* key;
+	//! Value, if owned
+	std::basic_string<charT> value;
+	//! Value, if borrowed (a null data() otherwise)
+	Basic_string_view<charT> ref;
+
+	//! The value, owned or borrowed
+	Basic_string_view<charT> view() const {
+		return (ref.data() != nullptr) ? ref : Basic_string_view<charT>(value);
+	}
+};
+
+/*! @brief Length of the string in an array: up to the first NUL, or all of it
+ *  A literal's terminator is the last element, but an array filled at run time
+ *  may end sooner, or not at all.
+ */
+template <typename charT, size_t N>
+size_t array_length(const charT (&value)[N]) {
+	for (size_t i = 0; i < N; ++i)
+		if (value[i] == charT())
+			return i;
+	return N;
+}
+
+inline Key_value<char> Key::operator () (const std::string& value) const {
+	return Key_value<char> { this, value, String_view() };
+}
+
+inline Key_value<wchar_t> Key::operator () (const std::wstring& value) const {
+	return Key_value<wchar_t> { this, value, WString_view() };
+}
+
+template <size_t N>
+Key_value<char> Key::operator () (const char (&value)[N]) const {
+	return borrow(String_view(value, array_length(value)));
+}
+
+template <size_t N>
+Key_value<wchar_t> Key::operator () (const wchar_t (&value)[N]) const {
+	return borrow(WString_view(value, array_length(value)));
+}
+
+template <size_t N>
+Key_value<char> Key::operator () (char (&value)[N]) const {
+	return (*this)(std::string(value, array_length(value)));
+}
+
+template <size_t N>
+Key_value<wchar_t> Key::operator () (wchar_t (&value)[N]) const {
+	return (*this)(std::wstring(value, array_length(value)));
+}
+
+inline Key_value<char> Key::borrow(String_view value) const {
+	return Key_value<char> { this, std::string(), value };
+}
+
+inline Key_value<wchar_t> Key::borrow(WString_view value) const {
+	return Key_value<wchar_t> { this, std::wstring(), value };
+}
+
+template <typename charT>
+Key_value<charT> Key::operator () (const Trusted<charT>& value) const {
+	return Key_value<charT> { this, std::basic_string<charT>(), value.text };
+}
+
+template <typename charT>
+Key_value<charT> Key::operator () (const Escaped<charT>& value) const {
+	return Key_value<charT> { this, value.text.str(), Basic_string_view<charT>() };
+}
+
+template <typename charT>
+Key_value<charT> Key::operator () (const Untrusted<charT>& value) const {
+	return Key_value<charT> { this, escape(value.text, context), Basic_string_view<charT>() };
+}
+
+#define MOSH_CGI_HTML_ATTR(ident_, name_, context_) \
+	constexpr Key ident_ = { id_##ident_, name_, sizeof(name_) - 1, " " name_ "=\"", sizeof(name_) + 2, \
+		Context::context_ };
+#include <mosh/cgi/html/element/attrs.def>
+#undef MOSH_CGI_HTML_ATTR
+
+/*! @brief Make a data: URI attribute from a buffer
+ *  The value ("data:<mime>;base64,<data>") is sized once and the data is base64-encoded
+ *  straight into it. Pass the result to an element on its own, or with +=, and it is
+ *  moved rather than copied: s::img(attr::data_uri(attr::src, "image/png", png)).
+ *  The encoded value is held whole until the element is rendered, and rendering
+ *  copies it once more, into the element's markup; a large payload is better
+ *  served as a resource of its own.
+ *  @tparam charT character type of the element
+ *  @param[in] k key, e.g. attr::src or attr::href
+ *  @param[in] mime media type, which is not escaped
+ *  @param[in] data bytes to embed
+ */
+template <typename charT = char>
+Key_value<charT> data_uri(const Key& k, String_view mime, String_view data);
+
+/*! @brief Make a data: URI attribute from a file
+ *  As data_uri(), with the file read in blocks and encoded block by block; the raw
+ *  file is never held whole, but the encoded value is.
+ *  @tparam charT character type of the element
+ *  @param[in] k key
+ *  @param[in] mime media type, which is not escaped
+ *  @param[in] path file to embed
+ *  @throw std::invalid_argument if the file cannot be read
+ */
+template <typename charT = char>
+Key_value<charT> data_uri_file(const Key& k, String_view mime, const std::string& path);
+
+/*! @brief Find a key by name
+ *  @param[in] name attribute name
+ *  @param[in] n length of name
+ *  @return the key, or a null pointer if the name is unknown
+ */
+const Key* find(const char* name, size_t n);
+
+/*! @brief Find a key by name
+ *  @param[in] name attribute name
+ *  @return the key, or a null pointer if the name is unknown
+ */
+inline const Key* find(const std::string& name) {
+	return find(name.data(), name.size());
+}
+
+/*! @brief Get a key by id
+ *  @param[in] id key id
+ *  @pre id < n_keys
+ */
+const Key& key(unsigned id);
+
+}
+
+/*! @brief Attribute list with interned keys
+ * Attributes are kept sorted by name, and adding a name which is already present
+ * has no effect, as with a std::map. Known names are stored as a pointer to their
+ * key, so adding them does not allocate, and they render as the pre-rendered
+ * prefix followed by the value.
+ */
+template <typename charT>
+class Attribute_list {
+public:
+	//! Typedef for strings
+	typedef std::basic_string<charT> string;
+
+	//! A list entry
+	struct Entry {
+		//! Key, or a null pointer for names not in attrs.def
+		const attr::Key* key;
+		//! Name, for names not in attrs.def
+		std::string other;
+		//! Value, if owned
+		string value;
+		//! Value, if borrowed (a null data() otherwise)
+		Basic_string_view<charT> ref;
+
+		//! Attribute name
+		const char* name() const {
+			return (key != nullptr) ? key->name : other.c_str();
+		}
+	};
+	typedef typename std::vector<Entry>::const_iterator const_iterator;
+
+	/*! @brief Add an attribute
+	 *  @param[in] k key
+	 *  @param[in] v value, which is copied
+	 *  @retval false if the name is already present
+	 */
+	bool insert(const attr::Key& k, Basic_string_view<charT> v) {
+		return _insert(&k, String_view(k.name, k.size), v, false);
+	}
+
+	/*! @brief Add an attribute, without copying its value
+	 *  @param[in] k key
+	 *  @param[in] v value, which must outlive the list
+	 *  @retval false if the name is already present
+	 */
+	bool insert_borrowed(const attr::Key& k, Basic_string_view<charT> v) {
+		return _insert(&k, String_view(k.name, k.size), v, true);
+	}
+
+	/*! @brief Add an attribute
+	 *  @param[in] n name
+	 *  @param[in] v value, which is copied
+	 *  @retval false if the name is already present
+	 */
+	bool insert(String_view n, Basic_string_view<charT> v) {
+		return _insert(attr::find(n.data(), n.size()), n, v, false);
+	}
+
+	//! Add an attribute; a borrowed value stays borrowed
+	bool insert(const attr::Key_value<charT>& kv) {
+		return _insert(kv.key, String_view(kv.key->name, kv.key->size), kv.view(), kv.ref.data() != nullptr);
+	}
+
+	//! Add an attribute; an owned value is moved in
+	bool insert(attr::Key_value<charT>&& kv) {
+		if (kv.ref.data() != nullptr)
+			return insert(kv);
+		return _insert(kv.key, String_view(kv.key->name, kv.key->size), Basic_string_view<charT>(), false,
+			&kv.value);
+	}
+
+	//! Add an attribute
+	bool insert(const std::pair<std::string, string>& a) {
+		return insert(a.first, a.second);
+	}
+
+	/*! @brief Append ` name="value"' for each attribute
+	 *  @param[in,out] s string to append to
+	 *  @warn No escaping is done.
+	 */
+	void append_to(string& s) const {
+		for (const auto& e : entries) {
+			if (e.key != nullptr) {
+				s.append(e.key->prefix, e.key->prefix + e.key->prefix_size);
+			} else {
+				s += static_cast<charT>(' ');
+				s.append(e.other.begin(), e.other.end());
+				s += static_cast<charT>('=');
+				s += static_cast<charT>('"');
+			}
+			if (e.ref.data() != nullptr)
+				s.append(e.ref.data(), e.ref.size());
+			else
+				s += e.value;
+			s += static_cast<charT>('"');
+		}
+	}
+
+	/*! @brief Append ` name="value"' for each attribute, as UTF-8
+	 *  @param[in,out] s string to append to
+	 *  @warn No escaping is done.
+	 */
+	void append_utf8_to(std::string& s) const {
+		for (const auto& e : entries) {
+			if (e.key != nullptr) {
+				s.append(e.key->prefix, e.key->prefix_size);
+			} else {
+				s += ' ';
+				s += e.other;
+				s += "=\"";
+			}
+			if (e.ref.data() != nullptr)
+				utf8::append(s, e.ref.data(), e.ref.size());
+			else
+				utf8::append(s, e.value);
+			s += '"';
+		}
+	}
+
+	//! Upper bound on the length of what append_to() appends
+	size_t rendered_size() const {
+		size_t n = 0;
+		for (const auto& e : entries)
+			n += ((e.key != nullptr) ? e.key->prefix_size : e.other.size() + 3)
+				+ ((e.ref.data() != nullptr) ? e.ref.size() : e.value.size()) + 1;
+		return n;
+	}
+
+	bool empty() const {
+		return entries.empty();
+	}
+	size_t size() const {
+		return entries.size();
+	}
+	const_iterator begin() const {
+		return entries.begin();
+	}
+	const_iterator end() const {
+		return entries.end();
+	}
+
+private:
+	bool _insert(const attr::Key* k, String_view n, Basic_string_view<charT> v, bool borrow,
+			string* owned = nullptr)
+	{
+		auto it = _lower_bound(n.data(), n.size());
+		if (it != entries.end() && _equal(*it, n.data(), n.size()))
+			return false;
+		Entry e { k, std::string(), string(), Basic_string_view<charT>() };
+		if (k == nullptr)
+			e.other.assign(n.data(), n.size());
+		if (borrow)
+			e.ref = v;
+		else if (owned != nullptr)
+			e.value = std::move(*owned);
+		else
+			e.value.assign(v.data(), v.size());
+		if (entries.empty()) {
+			entries.reserve(4);
+			it = entries.begin();
+		}
+		entries.insert(it, std::move(e));
+		return true;
+	}
+
+	static int _compare(const Entry& e, const char* n, size_t size) {
+		const char* en = e.name();
+		size_t es = (e.key != nullptr) ? e.key->size : e.other.size();
+		int c = std::memcmp(en, n, (es < size) ? es : size);
+		return (c != 0) ? c : (es < size) ? -1 : (es > size) ? 1 : 0;
+	}
+	static bool _equal(const Entry& e, const char* n, size_t size) {
+		return _compare(e, n, size) == 0;
+	}
+	typename std::vector<Entry>::iterator _lower_bound(const char* n, size_t size) {
+		auto it = entries.begin();
+		// Elements carry a handful of attributes; a linear scan beats bisection here
+		while (it != entries.end() && _compare(*it, n, size) < 0)
+			++it;
+		return it;
+	}
+
+	std::vector<Entry> entries;
+};
+
+}
+}
+MOSH_CGI_END
+
+#endif
@@ -0,0 +1,133 @@
+//! @file mosh/cgi/html/element/registry.hpp Runtime lookup of HTML elements by name
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_HTML_ELEMENT_REGISTRY_HPP
+#define MOSH_CGI_HTML_ELEMENT_REGISTRY_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <mosh/cgi/html/element.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+namespace html {
+namespace element {
+
+/*! @brief Registry of known elements
+ *  The registry is built from the same table (tags.def) as the s:: and ws:: catalogs.
+ *  Lookup by name goes through a perfect hash computed at compile time, so it costs
+ *  one hash, one table load and one comparison, and never allocates.
+ */
+namespace registry {
+
+//! DTD families, for Tag::dtds
+namespace dtd {
+	//! HTML 4.01 Strict, XHTML 1.0 Strict
+	const unsigned strict = 1 << 0;
+	//! HTML 4.01 Transitional, XHTML 1.0 Transitional
+	const unsigned transitional = 1 << 1;
+	//! HTML 4.01 Frameset, XHTML 1.0 Frameset
+	const unsigned frameset = 1 << 2;
+	//! XHTML 1.1, XHTML Basic and XHTML Mobile Profile
+	const unsigned xhtml_11 = 1 << 3;
+	//! HTML 5
+	const unsigned html_5 = 1 << 4;
+	//! All variants of HTML 4.01 and XHTML 1.0
+	const unsigned html_4 = strict | transitional | frameset;
+	//! Every DTD
+	const unsigned all = html_4 | xhtml_11 | html_5;
+
+	/*! @brief Get the DTD family of an HTML revision
+	 *  @param[in] hr HTML revision
+	 *  @throw std::invalid_argument if hr is not a known revision
+	 *  @sa html_doctype::html_revision
+	 */
+	unsigned from_revision(unsigned hr);
+}
+
+//! Tag descriptor
+struct Tag {
+	//! Element name
+	const char* name;
+	//! Length of name
+	size_t size;
+	//! Element type (Type::unary or Type::binary)
+	unsigned type;
+	//! DTDs which have this element
+	unsigned dtds;
+	//! Pre-rendered start of the opening tag ("<name")
+	const char* open;
+	//! Length of open
+	size_t open_size;
+	//! Pre-rendered closing tag ("</name>")
+	const char* close;
+	//! Length of close
+	size_t close_size;
+
+	/*! @brief Check whether an HTML revision has this element
+	 *  @param[in] hr HTML revision
+	 */
+	bool allowed_in(unsigned hr) const {
+		return (dtds & dtd::from_revision(hr)) != 0;
+	}
+};
+
+/*! @brief Find a tag by name
+ *  Names are matched case-sensitively; all known names are lower case.
+ *  @param[in] name element name
+ *  @param[in] n length of name
+ *  @return the tag descriptor, or a null pointer if the name is unknown
+ */
+const Tag* find(const char* name, size_t n);
+
+/*! @brief Find a tag by name
+ *  @param[in] name element name
+ *  @return the tag descriptor, or a null pointer if the name is unknown
+ */
+inline const Tag* find(const std::string& name) {
+	return find(name.data(), name.size());
+}
+
+/*! @name Iteration
+ * Tags are in alphabetical order.
+ */
+//@{
+const Tag* begin();
+const Tag* end();
+//@}
+
+/*! @brief Create an element by name
+ *  @param[in] name element name
+ *  @throw std::invalid_argument if name is unknown
+ */
+template <typename charT>
+Element<charT> make(const std::string& name) {
+	const Tag* t = find(name);
+	if (t == nullptr)
+		throw std::invalid_argument("MOSH_CGI::html::element::registry: unknown element");
+	return Element<charT>(t->type, std::string(t->name, t->size));
+}
+
+}
+
+}
+}
+MOSH_CGI_END
+
+#endif
@@ -0,0 +1,169 @@
+//! @file mosh/cgi/html/escape.hpp Context-aware escaping of untrusted text
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#ifndef MOSH_CGI_HTML_ESCAPE_HPP
+#define MOSH_CGI_HTML_ESCAPE_HPP
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+namespace html {
+
+/*! @brief Escaping contexts
+ * Where a piece of text ends up decides how it has to be escaped.
+ */
+namespace Context {
+	//! Content of an ordinary element: & < > become entities
+	const unsigned text = 0;
+	//! Quoted attribute value: as text, plus " and '
+	const unsigned attribute = 1;
+	/*! @brief URL-valued attribute (href, src, ...)
+	 * Only relative URLs and the http, https, ftp, mailto and tel schemes are let
+	 * through; anything else (javascript:, data:, ...) is replaced by
+	 * "about:invalid". Spaces, quotes, markup and non-ASCII characters are
+	 * percent-encoded, and & becomes &amp;.
+	 */
+	const unsigned url = 2;
+	/*! @brief Inside a quoted JavaScript string, in a <script> body or an event handler
+	 * Quotes and backslashes are backslash-escaped; markup, control characters and
+	 * U+2028/U+2029 become \\x and \\u escapes.
+	 */
+	const unsigned script = 3;
+	/*! @brief CSS, in a <style> body or a style attribute
+	 * Everything but ASCII letters, digits, non-ASCII characters and " -_.,#%" becomes
+	 * a \\HH escape.
+	 */
+	const unsigned style = 4;
+}
+
+/*! @name Text types
+ * Text passed to an element as a plain string is taken as pre-rendered markup and
+ * is appended as is. These wrappers say where text comes from instead:
+ * @li Trusted: a literal in the program, appended without being scanned;
+ * @li Escaped: a fragment which was escaped (or rendered) before, appended as is;
+ * @li Untrusted: user input, escaped once when it is added, according to the
+ *     context it is added to.
+ *
+ * The wrappers borrow their text, so they are meant to be made and consumed in
+ * the same expression: s::td(html::untrusted(name)).
+ */
+//@{
+template <typename charT>
+struct Trusted {
+	Basic_string_view<charT> text;
+};
+
+template <typename charT>
+struct Escaped {
+	Basic_string_view<charT> text;
+};
+
+template <typename charT>
+struct Untrusted {
+	Basic_string_view<charT> text;
+};
+
+//! Length of a constant array's string: up to the first NUL, or all of it
+template <typename charT, size_t N>
+constexpr size_t literal_length(const charT (&s)[N], size_t i = 0) {
+	return (i == N || s[i] == charT()) ? i : literal_length(s, i + 1);
+}
+
+//! Mark a string literal as trusted
+template <size_t N>
+constexpr Trusted<char> trusted(const char (&s)[N]) {
+	return Trusted<char> { String_view(s, literal_length(s)) };
+}
+//! Mark a string literal as trusted
+template <size_t N>
+constexpr Trusted<wchar_t> trusted(const wchar_t (&s)[N]) {
+	return Trusted<wchar_t> { WString_view(s, literal_length(s)) };
+}
+//! A modifiable array is filled at run time, so it is not trusted; use untrusted()
+template <size_t N>
+Trusted<char> trusted(char (&s)[N]) = delete;
+template <size_t N>
+Trusted<wchar_t> trusted(wchar_t (&s)[N]) = delete;
+
+inline Escaped<char> escaped(String_view s) {
+	return Escaped<char> { s };
+}
+inline Escaped<wchar_t> escaped(WString_view s) {
+	return Escaped<wchar_t> { s };
+}
+
+inline Untrusted<char> untrusted(String_view s) {
+	return Untrusted<char> { s };
+}
+inline Untrusted<wchar_t> untrusted(WString_view s) {
+	return Untrusted<wchar_t> { s };
+}
+
+//! Whether T is one of the text types over charT
+template <typename T, typename charT> struct is_text : std::false_type { };
+template <typename charT> struct is_text<Trusted<charT>, charT> : std::true_type { };
+template <typename charT> struct is_text<Escaped<charT>, charT> : std::true_type { };
+template <typename charT> struct is_text<Untrusted<charT>, charT> : std::true_type { };
+//@}
+
+/*! @brief Get the context of the content of an element
+ *  @param[in] name element name
+ *  @return Context::script for <script>, Context::style for <style>, else Context::text
+ */
+unsigned element_context(String_view name);
+
+/*! @brief Length of the leading part of a string which needs no escaping
+ *  A cheap check: when it returns s.size(), s can be appended as is.
+ *  @param[in] s text
+ *  @param[in] context one of Context
+ */
+template <typename charT>
+size_t safe_prefix(Basic_string_view<charT> s, unsigned context);
+
+/*! @brief Append escaped text
+ *  Runs of characters which need no escaping are copied in one go; the scan is
+ *  a table lookup per character.
+ *  @param[in,out] out string to append to
+ *  @param[in] s text
+ *  @param[in] context one of Context
+ */
+template <typename charT>
+void escape(std::basic_string<charT>& out, Basic_string_view<charT> s, unsigned context);
+
+/*! @brief Escape text
+ *  @param[in] s text
+ *  @param[in] context one of Context
+ */
+template <typename charT>
+std::basic_string<charT> escape(Basic_string_view<charT> s, unsigned context) {
+	std::basic_string<charT> out;
+	escape(out, s, context);
+	return out;
+}
+
+}
+
+MOSH_CGI_END
+
+#endif
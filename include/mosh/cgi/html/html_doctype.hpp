@@ -208,17 +208,57 @@ const uint32_t html_5 = make_revision(Family::html, 0, version::HTML::_4);
 
 }
 
+/*! @brief Get the external identifier for an HTML revision
+ *  @param[in] hr HTML revision
+ *  @return PUBLIC "fpi" "uri", or an empty string if the revision has no DTD
+ *  @throw std::invalid_argument if hr is not a known revision
+ */
 template <typename charT>
 std::basic_string<charT> html_identifier(unsigned hr) {
 	return wide_string<charT>(html_identifier<char>(hr));
 }
 template<> std::string html_identifier<char>(unsigned hr);
 
+/*! @brief Get the document type declaration for an HTML revision
+ *  @param[in] hr HTML revision
+ *  @throw std::invalid_argument if hr is not a known revision
+ */
 template <typename charT>
 sgml_doctype::Doctype_declaration<charT> html_doctype(unsigned hr) {
 	return sgml_doctype::Doctype_declaration<charT>(wide_string<charT>("html"), html_identifier<charT>(hr));
 }
 
+//! Pre-rendered start of a document
+template <typename charT>
+struct Prologue {
+	//! <?xml version="1.0"?>, for XHTML; empty otherwise
+	std::basic_string<charT> xml_declaration;
+	//! <!DOCTYPE html ...>
+	std::basic_string<charT> doctype;
+	//! xmlns="...", for XHTML; empty otherwise
+	std::basic_string<charT> xmlns;
+	//! All of the above followed by <html xmlns="...">
+	std::basic_string<charT> full;
+};
+
+/*! @brief Get the pre-rendered prologue for an HTML revision
+ *  Each prologue is rendered on first use and cached for the lifetime of the process.
+ *  Only @c char and @c wchar_t are instantiated.
+ *  @param[in] hr HTML revision
+ *  @throw std::invalid_argument if hr is not a known revision
+ */
+template <typename charT>
+const Prologue<charT>& prologue(unsigned hr);
+
+/*! @name Explicit instantiations
+ * The @c char and @c wchar_t instantiations are compiled once, into libmosh_cgi.
+ */
+//@{
+extern template std::wstring html_identifier<wchar_t>(unsigned);
+extern template sgml_doctype::Doctype_declaration<char> html_doctype<char>(unsigned);
+extern template sgml_doctype::Doctype_declaration<wchar_t> html_doctype<wchar_t>(unsigned);
+//@}
+
 }
 }
 
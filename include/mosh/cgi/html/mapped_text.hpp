@@ -0,0 +1,106 @@
+//! @file mosh/cgi/html/mapped_text.hpp Large static content, mapped from files
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_HTML_MAPPED_TEXT_HPP
+#define MOSH_CGI_HTML_MAPPED_TEXT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+namespace html {
+
+/*! @brief Raw content, such as a stylesheet or script, read from a file
+ * The file is mapped read-only and the content used from the mapping as it is,
+ * without escaping: written to a Response, it goes out with writev(2) from the
+ * mapped pages; written to any other stream, it is handed to the stream buffer
+ * from them. Its hash is taken once, when the file is mapped.
+ * @code
+ * const html::Mapped_text css("/srv/app/styles.css");
+ * r << "<style type=\"text/css\">" << css << "</style>";
+ * @endcode
+ * Mappings are cached by path, so in a persistent process a file is mapped once,
+ * and only checked (with one stat(2)) each time it is named again; it is mapped
+ * anew if its modification time, size or inode have changed. A mapping lives as
+ * long as any Mapped_text, or response, which uses it.
+ *
+ * A file should be replaced, e.g. by renaming a new one over it, rather than
+ * rewritten in place: the pages of a mapping are those of the file.
+ */
+class Mapped_text {
+public:
+	/*! @brief Map a file, or use the mapping made already
+	 *  @param[in] path file name
+	 *  @throw std::invalid_argument if the file cannot be opened or mapped
+	 */
+	explicit Mapped_text(const std::string& path);
+
+	//! Content
+	const char* data() const {
+		return _data;
+	}
+
+	//! Length of the content
+	size_t size() const {
+		return _size;
+	}
+
+	//! Content
+	String_view view() const {
+		return String_view(_data, _size);
+	}
+
+	//! xxh64 hash of the content, e.g. for make_etag()
+	uint64_t hash() const {
+		return _hash;
+	}
+
+	//! Keeps the mapping alive
+	const std::shared_ptr<const void>& mapping() const {
+		return _mapping;
+	}
+
+	/*! @brief Drop cached mappings
+	 *  Mappings still in use stay valid for as long as they are used.
+	 */
+	static void clear_cache();
+
+private:
+	std::shared_ptr<const void> _mapping;
+	const char* _data;
+	size_t _size;
+	uint64_t _hash;
+};
+
+/*! @brief Write mapped content
+ *  @param[in,out] os stream
+ *  @param[in] t content
+ */
+std::ostream& operator << (std::ostream& os, const Mapped_text& t);
+
+}
+
+MOSH_CGI_END
+
+#endif
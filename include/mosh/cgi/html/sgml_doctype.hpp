@@ -153,12 +153,16 @@ public:
 
 	//! Convert to string
 	operator string () const {
-		string s = name	+ wide_char<charT>(' ') + external;
+		string s = wide_string<charT>("<!DOCTYPE ") + name;
+		if (!external.empty()) {
+			s += wide_char<charT>(' ');
+			s += external;
+		}
 		if (!internal.empty()) {
 			s += wide_string<charT>(" [\r\n")
-				+ internal + wide_string<charT>("\n] ");
+				+ internal + wide_string<charT>("\r\n]");
 		}
-		s += wide_string<charT>(" >\r\n");
+		s += wide_char<charT>('>');
 		return s;
 	}
 	
@@ -190,6 +194,16 @@ Doctype_declaration<charT> operator + (Doctype_declaration<charT> && _d, const s
 	return std::move(d);
 }
 
+/*! @name Explicit instantiations
+ * The @c char and @c wchar_t instantiations are compiled once, into libmosh_cgi.
+ */
+//@{
+extern template class External_doctype_identifier<char>;
+extern template class External_doctype_identifier<wchar_t>;
+extern template class Doctype_declaration<char>;
+extern template class Doctype_declaration<wchar_t>;
+//@}
+
 }
 }
 
@@ -0,0 +1,504 @@
+//! @file mosh/cgi/html/static_element.hpp Statically dispatched HTML elements
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#ifndef MOSH_CGI_HTML_STATIC_ELEMENT_HPP
+#define MOSH_CGI_HTML_STATIC_ELEMENT_HPP
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <ostream>
+#include <mosh/cgi/html/element.hpp>
+#include <mosh/cgi/html/element/attr.hpp>
+#include <mosh/cgi/html/escape.hpp>
+#include <mosh/cgi/html/html_doctype.hpp>
+#include <mosh/cgi/bits/t_string.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/utf8.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+namespace html {
+
+namespace element {
+
+/*! @brief Base of the statically dispatched elements
+ * This is the CRTP counterpart of Element: @c Derived may hide
+ * attribute_addition_hook(), data_addition_hook() and render(), and the calls
+ * resolve at compile time. There are no virtual functions, so elements carry
+ * no vptr and the hooks can be inlined. Use Element where runtime
+ * polymorphism is needed.
+ *
+ * Attributes are kept in an Attribute_list, so keys from attr:: (and string
+ * names which match them) are stored without allocating. Values are taken as
+ * Basic_string_view, so literals are appended without a temporary string.
+ * Values wrapped in Untrusted are escaped for the element's content (text, or
+ * script or CSS for <script> and <style>); Trusted and Escaped values skip the scan.
+ *
+ * A derived class which hides render() hides render_utf8() too, and a derived class
+ * which hides a hook must befriend its base.
+ * @tparam charT character type
+ * @tparam Derived the derived class
+ */
+template <typename charT, typename Derived>
+class Element_base {
+public:
+	//! Typedef for strings
+	typedef typename std::basic_string<charT> string;
+	//! Typedef for attributes
+	typedef typename std::pair<std::string, string> attribute;
+	//! Typedef for attributes with a known key
+	typedef attr::Key_value<charT> key_attribute;
+	//! Typedef for attribute lists
+	typedef Attribute_list<charT> attr_list;
+
+	/*! @name Clone and call
+	 * These overloads create new elements which behave as if attributes and values 
+	 * were appended to existing elements. Any argument accepted by operator +=
+	 * is accepted here.
+	 */
+	//@{
+	Derived operator () () const {
+		return Derived(_derived());
+	}
+	template <typename T>
+	Derived operator () (T&& _x) const {
+		Derived e(_derived());
+		e += std::forward<T>(_x);
+		return e;
+	}
+	Derived operator () (std::initializer_list<attribute> _a) const {
+		Derived e(_derived());
+		e += _a;
+		return e;
+	}
+	Derived operator () (std::initializer_list<key_attribute> _a) const {
+		Derived e(_derived());
+		e += _a;
+		return e;
+	}
+	Derived operator () (std::initializer_list<string> _v) const {
+		Derived e(_derived());
+		e += _v;
+		return e;
+	}
+	template <typename A, typename V>
+	Derived operator () (A&& _a, V&& _v) const {
+		Derived e(_derived());
+		e += std::forward<A>(_a);
+		e += std::forward<V>(_v);
+		return e;
+	}
+	template <typename V>
+	Derived operator () (std::initializer_list<attribute> _a, const V& _v) const {
+		Derived e(_derived());
+		e += _a;
+		e += _v;
+		return e;
+	}
+	template <typename V>
+	Derived operator () (std::initializer_list<key_attribute> _a, const V& _v) const {
+		Derived e(_derived());
+		e += _a;
+		e += _v;
+		return e;
+	}
+	template <typename A>
+	Derived operator () (const A& _a, std::initializer_list<string> _v) const {
+		Derived e(_derived());
+		e += _a;
+		e += _v;
+		return e;
+	}
+	Derived operator () (std::initializer_list<attribute> _a, std::initializer_list<string> _v) const {
+		Derived e(_derived());
+		e += _a;
+		e += _v;
+		return e;
+	}
+	Derived operator () (std::initializer_list<key_attribute> _a, std::initializer_list<string> _v) const {
+		Derived e(_derived());
+		e += _a;
+		e += _v;
+		return e;
+	}
+	//@}
+
+	/*! @name Appenders
+	 */
+	//@{
+	Derived& operator += (const attribute& _a) {
+		if (_derived().attribute_addition_hook(String_view(_a.first), Basic_string_view<charT>(_a.second)))
+			attributes.insert(_a);
+		return _derived();
+	}
+	Derived& operator += (std::initializer_list<attribute> _a) {
+		for (const auto& at : _a)
+			*this += at;
+		return _derived();
+	}
+	//! Add an attribute; a borrowed value (see attr::Key) stays borrowed
+	Derived& operator += (const key_attribute& _a) {
+		if (_derived().attribute_addition_hook(String_view(_a.key->name, _a.key->size), _a.view()))
+			attributes.insert(_a);
+		return _derived();
+	}
+	//! Add an attribute; an owned value is moved in
+	Derived& operator += (key_attribute&& _a) {
+		if (_derived().attribute_addition_hook(String_view(_a.key->name, _a.key->size), _a.view()))
+			attributes.insert(std::move(_a));
+		return _derived();
+	}
+	Derived& operator += (std::initializer_list<key_attribute> _a) {
+		for (const auto& at : _a)
+			*this += at;
+		return _derived();
+	}
+	//! Add an attribute made by P(); a known name goes in by key, with the value borrowed
+	Derived& operator += (const Attribute_ref<charT>& _a) {
+		const attr::Key* k = attr::find(_a.name.data(), _a.name.size());
+		if (k != nullptr)
+			return *this += k->borrow(_a.value);
+		return *this += attribute(_a);
+	}
+	//! Add a value: a string, a literal or a view, appended without a temporary
+	Derived& operator += (Basic_string_view<charT> _v) {
+		if (_derived().data_addition_hook(_v))
+			data += _v;
+		return _derived();
+	}
+	Derived& operator += (std::initializer_list<string> _v) {
+		for (const auto& vv : _v)
+			*this += Basic_string_view<charT>(vv);
+		return _derived();
+	}
+	//! Add a trusted literal, without scanning it
+	Derived& operator += (const Trusted<charT>& _v) {
+		return *this += _v.text;
+	}
+	//! Add an escaped fragment as is
+	Derived& operator += (const Escaped<charT>& _v) {
+		return *this += _v.text;
+	}
+	//! Add untrusted text, escaped for the content of this element
+	Derived& operator += (const Untrusted<charT>& _v) {
+		const unsigned context = element_context(name);
+		if (safe_prefix(_v.text, context) == _v.text.size())
+			return *this += _v.text;
+		const string s = escape(_v.text, context);
+		return *this += Basic_string_view<charT>(s);
+	}
+	//! Add a rendered element
+	template <typename D>
+	Derived& operator += (const Element_base<charT, D>& _e) {
+		const string s = _e;
+		return *this += Basic_string_view<charT>(s);
+	}
+	//! Add a rendered element
+	Derived& operator += (const Element<charT>& _e) {
+		const string s = _e;
+		return *this += Basic_string_view<charT>(s);
+	}
+	//@}
+
+	/*! @brief String cast operator
+	 *  Renders the element, with attributes and pre-rendered data.
+	 *  @warn No escaping is done.
+	 */
+	operator string () const {
+		string s;
+		_derived().render(s);
+		return s;
+	}
+
+	/*! @brief Append the rendered element to a UTF-8 string
+	 *  Wide elements are encoded piece by piece, with no wide rendering in between.
+	 *  @warn No escaping is done.
+	 */
+	void append_utf8(std::string& s) const {
+		_derived().render_utf8(s);
+	}
+
+protected:
+	/*! @brief Create a new element with a given name and type
+	 *  @param[in] type_ Element type
+	 *  @param[in] name_ Element name
+	 *  @sa Type
+	 */
+	Element_base(unsigned type_, const std::string& name_)
+	: type(type_), name(name_), attributes(), data()
+	{ }
+
+	/*! @brief Type-exposing constructor for derived classes
+	 *  @param[in] type_ Type
+	 */
+	Element_base(unsigned type_)
+	: type(type_), name(), attributes(), data()
+	{ }
+
+	//! Not for deletion through a base pointer
+	~Element_base() { }
+
+	//! Hook for attribute addition; hide it to check or redirect attributes
+	bool attribute_addition_hook(String_view /* name */, Basic_string_view<charT> /* value */) { return true; }
+	//! Hook for data addition; hide it to check or redirect data
+	bool data_addition_hook(Basic_string_view<charT>) { return true; }
+
+	//! Append the rendered element to s; hide it to render differently
+	void render(string& s) const {
+		s.reserve(s.size() + 2 * name.size() + attributes.rendered_size() + data.size() + 5);
+		s += wide_char<charT>('<');
+		s.append(name.begin(), name.end());
+		attributes.append_to(s);
+		if (type == Type::unary) {
+			s += wide_char<charT>(' ');
+			s += wide_char<charT>('/');
+		} else {
+			if (type == Type::binary)
+				s += wide_char<charT>('>');
+			s += data;
+			if (type == Type::binary) {
+				s += wide_char<charT>('<');
+				s += wide_char<charT>('/');
+				s.append(name.begin(), name.end());
+			} else if (type == Type::comment) {
+				s += wide_char<charT>('-');
+				s += wide_char<charT>('-');
+			}
+		}
+		s += wide_char<charT>('>');
+	}
+
+	//! Append the rendered element to s as UTF-8; hide it along with render()
+	void render_utf8(std::string& s) const {
+		s += '<';
+		s += name;
+		attributes.append_utf8_to(s);
+		if (type == Type::unary) {
+			s += " /";
+		} else {
+			if (type == Type::binary)
+				s += '>';
+			utf8::append(s, data);
+			if (type == Type::binary) {
+				s += "</";
+				s += name;
+			} else if (type == Type::comment) {
+				s += "--";
+			}
+		}
+		s += '>';
+	}
+
+	//! Element type
+	unsigned type;
+	//! Element name (ASCII)
+	std::string name;
+	//! List of attributes
+	attr_list attributes;
+	//! Pre-rendered embedded data
+	string data;
+
+private:
+	Derived& _derived() {
+		return static_cast<Derived&>(*this);
+	}
+	const Derived& _derived() const {
+		return static_cast<const Derived&>(*this);
+	}
+};
+
+//! A statically dispatched HTML element
+template <typename charT>
+class Static_element : public Element_base<charT, Static_element<charT>> {
+	typedef Element_base<charT, Static_element<charT>> base_type;
+public:
+	/*! @brief Create a new element with a given name and type
+	 *  @param[in] type_ Element type
+	 *  @param[in] name_ Element name
+	 *  @sa Type
+	 */
+	Static_element(unsigned type_, const std::string& name_)
+	: base_type(type_, name_)
+	{
+		Type::_validate(type_);
+	}
+
+	/*! @brief Create a new element from a catalog entry
+	 *  e.g. Static_element<char> td = s::td;
+	 *  @param[in] p prototype
+	 */
+	Static_element(const Element_prototype<charT>& p)
+	: base_type(p.type, p.name)
+	{ }
+};
+
+/*! @brief Statically dispatched HTML begin class
+ * As HTML_begin: outputs <!DOCTYPE ...><html ...>, with <?xml ...?> and xmlns for XHTML.
+ * Attributes in the form of { "xml=foo", "bar" } go to the <?xml ?>; data added is
+ * assumed to be valid SGML DTD.
+ */
+template <typename charT>
+class Static_HTML_begin : public Element_base<charT, Static_HTML_begin<charT>> {
+	typedef Element_base<charT, Static_HTML_begin<charT>> base_type;
+	friend class Element_base<charT, Static_HTML_begin<charT>>;
+public:
+	typedef typename base_type::string string;
+	typedef typename base_type::attribute attribute;
+	typedef typename base_type::attr_list attr_list;
+
+	/*! @brief Create a new HTML start with a given type
+	 *  @param[in] type_ HTML type
+	 *  @sa doctype::HTML_revision
+	 */
+	Static_HTML_begin(unsigned type_ = html_doctype::html_revision::xhtml_10_strict)
+	: base_type(type_), prologue(&html_doctype::prologue<charT>(type_)), internal_dtd(), xml_attributes()
+	{ }
+
+protected:
+	bool attribute_addition_hook(String_view name, Basic_string_view<charT> value) {
+		if (is_xhtml()) {
+			if (name == String_view("lang", 4))
+				this->attributes.insert(attr::xml_lang, value);
+			if (name.size() >= 4 && !std::memcmp(name.data(), "xml=", 4)) {
+				this->xml_attributes.insert(String_view(name.data() + 4, name.size() - 4), value);
+				return false;
+			}
+		}
+		return true;
+	}
+	bool data_addition_hook(Basic_string_view<charT> _s) {
+		internal_dtd += _s;
+		return false;
+	}
+
+	void render(string& s) const {
+		if (this->attributes.empty() && this->xml_attributes.empty() && this->internal_dtd.empty()) {
+			s += this->prologue->full;
+			return;
+		}
+		if (is_xhtml()) {
+			if (this->xml_attributes.empty()) {
+				s += this->prologue->xml_declaration;
+			} else {
+				s += wide_string<charT>("<?xml version=\"1.0\"");
+				this->xml_attributes.append_to(s);
+				s += wide_string<charT>("?>");
+			}
+			s += wide_string<charT>("\r\n");
+		}
+		if (this->internal_dtd.empty()) {
+			s += this->prologue->doctype;
+		} else {
+			string d = html_doctype::html_doctype<charT>(this->type) + this->internal_dtd;
+			s += d;
+		}
+		s += wide_string<charT>("\r\n<html");
+		if (is_xhtml()) {
+			s += wide_char<charT>(' ');
+			s += this->prologue->xmlns;
+		}
+		this->attributes.append_to(s);
+		s += wide_char<charT>('>');
+	}
+
+	void render_utf8(std::string& s) const {
+		string w;
+		render(w);
+		utf8::append(s, w);
+	}
+
+	//! Cached prologue for this revision
+	const html_doctype::Prologue<charT>* prologue;
+	//! Internal DTD
+	string internal_dtd;
+	//! List of <?xml attributes.
+	attr_list xml_attributes;
+
+private:
+	bool is_xhtml() const {
+		using namespace html_doctype::html_revision;
+		return (get_family(this->type) == static_cast<uint8_t>(Family::xhtml));
+	}
+};
+
+/*! @brief Statically dispatched body begin class
+ * As Body_begin: outputs <body ...>; data added is discarded.
+ */
+template <typename charT>
+class Static_body_begin : public Element_base<charT, Static_body_begin<charT>> {
+	typedef Element_base<charT, Static_body_begin<charT>> base_type;
+	friend class Element_base<charT, Static_body_begin<charT>>;
+public:
+	typedef typename base_type::string string;
+
+	//! Default constructor
+	Static_body_begin()
+	: base_type(Type::binary, "body")
+	{ }
+
+protected:
+	// Don't append data
+	bool data_addition_hook(Basic_string_view<charT>) { return false; }
+
+	void render(string& s) const {
+		s += wide_string<charT>("<body");
+		this->attributes.append_to(s);
+		s += wide_char<charT>('>');
+	}
+
+	void render_utf8(std::string& s) const {
+		s += "<body";
+		this->attributes.append_utf8_to(s);
+		s += '>';
+	}
+};
+
+template <typename charT, typename Derived>
+std::basic_ostream<charT>& operator << (std::basic_ostream<charT>& os, const Element_base<charT, Derived>& e) {
+	os << static_cast<std::basic_string<charT>>(e);
+	return os;
+}
+
+/*! @name Explicit instantiations
+ * The @c char and @c wchar_t instantiations are compiled once, into libmosh_cgi.
+ */
+//@{
+extern template class Element_base<char, Static_element<char>>;
+extern template class Element_base<char, Static_HTML_begin<char>>;
+extern template class Element_base<char, Static_body_begin<char>>;
+extern template class Static_element<char>;
+extern template class Static_HTML_begin<char>;
+extern template class Static_body_begin<char>;
+extern template class Element_base<wchar_t, Static_element<wchar_t>>;
+extern template class Element_base<wchar_t, Static_HTML_begin<wchar_t>>;
+extern template class Element_base<wchar_t, Static_body_begin<wchar_t>>;
+extern template class Static_element<wchar_t>;
+extern template class Static_HTML_begin<wchar_t>;
+extern template class Static_body_begin<wchar_t>;
+//@}
+
+}
+
+}
+
+MOSH_CGI_END
+
+#endif
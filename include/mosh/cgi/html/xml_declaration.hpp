@@ -49,7 +49,7 @@ public:
 	//! Default constructor
 	XML_declaration()
 	{
-		attributes.insert(std::make_pair("version", "1.0"));
+		attributes.insert(std::make_pair(wide_string<charT>("version"), wide_string<charT>("1.0")));
 	}
 	//! Copy constructor
 	XML_declaration(const XML_declaration& x)
@@ -213,6 +213,14 @@ XML_declaration<charT> operator + (XML_declaration<charT>&& _e,
 	return std::move(e);
 }
 
+/*! @name Explicit instantiations
+ * The @c char and @c wchar_t instantiations are compiled once, into libmosh_cgi.
+ */
+//@{
+extern template class XML_declaration<char>;
+extern template class XML_declaration<wchar_t>;
+//@}
+
 }
 
 MOSH_CGI_END
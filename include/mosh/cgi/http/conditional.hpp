@@ -0,0 +1,165 @@
+//! @file mosh/cgi/http/conditional.hpp Validators and responses rendered on demand
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_HTTP_CONDITIONAL_HPP
+#define MOSH_CGI_HTTP_CONDITIONAL_HPP
+
+#include <ctime>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+//! The parts of a request which bear on whether to send a body
+struct Request_conditions {
+	//! Request method, e.g. "GET"
+	std::string method;
+	//! If-None-Match, or empty
+	std::string if_none_match;
+	//! If-Modified-Since, or empty
+	std::string if_modified_since;
+	//! Range, or empty
+	std::string range;
+	//! If-Range, or empty
+	std::string if_range;
+
+	//! Whether the method is HEAD, which never gets a body
+	bool head() const {
+		return method == "HEAD";
+	}
+
+	//! Whether the method is GET or HEAD, to which 304 applies
+	bool safe() const {
+		return method == "GET" || method == "HEAD";
+	}
+};
+
+/*! @brief Collect the request conditions passed through a CGI environment
+ *  @param[in] envp NULL-terminated environment block, as in @c environ
+ */
+Request_conditions request_conditions(const char* const* envp);
+
+/*! @brief Validators of a response, known before its body is rendered
+ * A version token is anything which changes when the content does, such as a row
+ * version or the mtime and size of a source file; it becomes a strong ETag. With
+ * only a Last-Modified time, If-Modified-Since is honoured to the second.
+ */
+class Validators {
+public:
+	//! No validators
+	Validators()
+	: _etag(), _last_modified(0), has_last_modified(false)
+	{ }
+
+	/*! @brief Declare the modification time
+	 *  @param[in] t time of the last change to the content
+	 */
+	Validators& last_modified(time_t t) {
+		_last_modified = t;
+		has_last_modified = true;
+		return *this;
+	}
+
+	/*! @brief Declare a version token
+	 *  @param[in] token version; printable ASCII other than '"'
+	 *  @throw std::invalid_argument if token has a character not allowed in an ETag
+	 */
+	Validators& version(String_view token);
+
+	/*! @brief Declare an entity tag
+	 *  @param[in] tag tag, quoted and optionally weak, e.g. "\"v42\"" or "W/\"v42\""
+	 */
+	Validators& etag(String_view tag) {
+		_etag = tag.str();
+		return *this;
+	}
+
+	//! The entity tag, or an empty string
+	const std::string& etag() const {
+		return _etag;
+	}
+
+	/*! @brief Check a request's conditions
+	 *  Follows RFC 7232, section 6: If-None-Match takes precedence, and
+	 *  If-Modified-Since is only looked at without it.
+	 *  @param[in] c request conditions
+	 *  @return 304 or 412 if the response is to be cut short with that status,
+	 *    and 0 if the full response is to be sent
+	 */
+	unsigned evaluate(const Request_conditions& c) const;
+
+	/*! @brief Get the Range to answer
+	 *  A Range is only answered if If-Range, when there is one, names the current
+	 *  version: by a strong ETag equal to the declared one, or by a date equal to
+	 *  the declared modification time. Otherwise the whole representation is sent.
+	 *  @param[in] c request conditions
+	 *  @return the Range field to answer, or an empty view
+	 *  @sa Response::ranges
+	 */
+	String_view range(const Request_conditions& c) const;
+
+	/*! @brief Add ETag and Last-Modified fields for the declared validators
+	 *  @param[in,out] h header
+	 */
+	void add_to(header::Header& h) const;
+
+private:
+	std::string _etag;
+	time_t _last_modified;
+	bool has_last_modified;
+};
+
+//! Body producer, called with the stream to render to
+typedef std::function<void (std::ostream&)> Body_producer;
+
+/*! @brief Send a response, rendering its body only if it is needed
+ * The validators are added to the header and checked against the request. For a
+ * HEAD request, or if the client's copy is current (304) or a precondition fails
+ * (412), only the header is written and @c body is never called:
+ * @code
+ * header::Header h = header::content_type("text/html");
+ * http::Validators v;
+ * v.last_modified(report.mtime).version(report.revision);
+ * http::send_deferred(cout, h, v, http::request_conditions(environ),
+ *	[&](std::ostream& os) { os << render(report); });
+ * @endcode
+ * Validators are only checked for a response with no Status or a 2xx Status.
+ * If the stream is a Response, the header is not written but left to it: the
+ * fields and any 304 or 412 Status go into its header (with @c h appended to it
+ * first, if @c h is another header).
+ * @param[in,out] os stream
+ * @param[in,out] h response header
+ * @param[in] v validators
+ * @param[in] c request conditions
+ * @param[in] body body producer
+ * @return whether the body was rendered
+ */
+bool send_deferred(std::ostream& os, header::Header& h, const Validators& v,
+	const Request_conditions& c, const Body_producer& body);
+
+}
+
+MOSH_CGI_END
+
+#endif
@@ -25,6 +25,7 @@
 
 #include <initializer_list>
 #include <string>
+#include <mosh/cgi/bits/string_view.hpp>
 #include <mosh/cgi/bits/namespace.hpp>
 
 MOSH_CGI_BEGIN
@@ -38,13 +39,15 @@ class Cookie {
 public:
 	//! Default constructor
 	Cookie()
+	: max_age(0), secure(false), http_only(true), removed(false)
 	{ }
 	/*! @brief Create a cookie
 	 *  @param[in] name_ cookie name
 	 *  @param[in] value_ cookie value
 	 */
-	Cookie(const std::string& name_, const std::string& value_) noexcept
-	: name(name_), value(value_)
+	Cookie(String_view name_, String_view value_) noexcept
+	: name(name_.data(), name_.size()), value(value_.data(), value_.size()),
+		max_age(0), secure(false), http_only(true), removed(false)
 	{ }
 
 	/*! @brief Create a cookie ({} form)
@@ -73,10 +76,12 @@ public:
 	 *  @param[in] secure_ specifies whether this is a secure cookie
 	 *  @param[in] http_only_ specified whether HTTP-only scope restriction is in effect
 	 */
-	Cookie(const std::string& name_, const std::string& value_, const std::string& comment_,
-	           const std::string& domain_, unsigned long max_age_, const std::string& path_,
+	Cookie(String_view name_, String_view value_, String_view comment_,
+	           String_view domain_, unsigned long max_age_, String_view path_,
 		   bool secure_ = false, bool http_only_ = true) noexcept
-	: name(name_), value(value_), comment(comment_), max_age(max_age_), domain(domain_), path(path_),
+	: name(name_.data(), name_.size()), value(value_.data(), value_.size()),
+		comment(comment_.data(), comment_.size()), max_age(max_age_),
+		domain(domain_.data(), domain_.size()), path(path_.data(), path_.size()),
 		secure(secure_), http_only(http_only_), removed(false)
 	{ }
 	//! Copy constructor
@@ -102,8 +107,8 @@ public:
 	 *  @param[in] http_only_ specified whether HTTP-only scope restriction is in effect
 	 *  @return a deleted cookie
 	 */
-	static Cookie deleted(const std::string& name_, const std::string& domain_, 
-					const std::string& path_, bool secure_, bool http_only_) noexcept
+	static Cookie deleted(String_view name_, String_view domain_, 
+					String_view path_, bool secure_, bool http_only_) noexcept
 	{
 		Cookie c(name_, "" /* value */, "" /* comment */,  domain_, 0, path_, secure_, http_only_);
 		c.removed = true;
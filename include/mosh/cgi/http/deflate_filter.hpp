@@ -0,0 +1,262 @@
+//! @file mosh/cgi/http/deflate_filter.hpp Compressing output stage
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_HTTP_DEFLATE_FILTER_HPP
+#define MOSH_CGI_HTTP_DEFLATE_FILTER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+//! Content codings
+namespace Coding {
+	//! No compression
+	const unsigned identity = 0;
+	//! zlib format (RFC 1950), which is what HTTP calls "deflate"
+	const unsigned deflate = 1;
+	//! gzip format (RFC 1952)
+	const unsigned gzip = 2;
+}
+
+//! Compression levels; anything from 0 to 9 will do
+namespace Deflate_level {
+	//! Store only
+	const int none = 0;
+	//! Fastest compression
+	const int fastest = 1;
+	//! zlib's default, currently 6
+	const int standard = -1;
+	//! Best compression
+	const int best = 9;
+}
+
+/*! @brief Get the name of a content coding, as in Content-Encoding
+ *  @param[in] coding one of Coding
+ *  @return the name, or a null pointer for Coding::identity
+ */
+const char* coding_name(unsigned coding);
+
+/*! @brief Choose a content coding from an Accept-Encoding value
+ *  Codings with a higher q-value win; gzip wins a tie with deflate. "x-gzip" is
+ *  taken as gzip, and "*" covers the codings which are not listed.
+ *  @param[in] accept_encoding the request's Accept-Encoding, or an empty view
+ *  @return one of Coding; Coding::identity if neither gzip nor deflate is acceptable
+ */
+unsigned negotiate_coding(String_view accept_encoding);
+
+/*! @brief A fragment kept both as is and compressed
+ * Compressing a fragment once, when it is cached, lets every compressed response
+ * which includes it splice in the compressed form (see Deflate_filter::splice()),
+ * so that the cost of compression scales with the dynamic part of a response only.
+ *
+ * The compressed form is a run of raw deflate blocks which starts from an empty
+ * window and ends with a full flush, i.e. on a byte boundary and without being the
+ * final block; that makes it valid wherever a full flush may appear in a stream.
+ */
+class Deflated_fragment {
+public:
+	/*! @brief Compress a fragment
+	 *  @param[in] raw fragment
+	 *  @param[in] level compression level; see Deflate_level. Compression is done
+	 *    once, so it defaults to the best
+	 *  @throw std::invalid_argument if level is out of range
+	 *  @throw std::runtime_error if zlib fails to compress all of it
+	 */
+	explicit Deflated_fragment(String_view raw, int level = Deflate_level::best);
+
+	//! The fragment as is
+	const std::string& raw() const {
+		return _raw;
+	}
+
+	//! The compressed fragment
+	const std::string& deflated() const {
+		return _deflated;
+	}
+
+	//! Length of the fragment
+	size_t size() const {
+		return _raw.size();
+	}
+
+	//! CRC-32 of the fragment, for gzip
+	uint32_t crc32() const {
+		return _crc32;
+	}
+
+	//! Adler-32 of the fragment, for zlib
+	uint32_t adler32() const {
+		return _adler32;
+	}
+
+private:
+	std::string _raw;
+	std::string _deflated;
+	uint32_t _crc32;
+	uint32_t _adler32;
+};
+
+/*! @brief Output filter which compresses with zlib
+ * Compresses what passes through in the given coding. Output is buffered in blocks
+ * and compressed as each block fills, so a response of any size is compressed in
+ * constant memory. sync() (i.e. flushing the stream) also flushes the compressor,
+ * so that what was written so far can be decompressed; it costs a few bytes and
+ * some compression, so flush only where it matters.
+ *
+ * A preset dictionary primes the compressor with strings which are expected in the
+ * output, such as the markup a site's pages share, so that even a small response
+ * refers back to it instead of spelling it out. The receiver needs the same
+ * dictionary to decompress (the stream names it by its Adler-32), and only the
+ * zlib format can carry one.
+ */
+class Deflate_filter : public std::streambuf {
+public:
+	/*! @brief Compress output to a buffer
+	 *  @param[in] dest buffer to write to
+	 *  @param[in] coding Coding::deflate or Coding::gzip
+	 *  @param[in] level compression level; see Deflate_level
+	 *  @param[in] dictionary preset dictionary, or an empty view
+	 *  @throw std::invalid_argument if coding or level is out of range, or a
+	 *    dictionary is given with Coding::gzip
+	 */
+	Deflate_filter(std::streambuf* dest, unsigned coding, int level = Deflate_level::standard,
+		String_view dictionary = String_view());
+
+	//! Calls finish()
+	~Deflate_filter();
+
+	/*! @brief Write out a precompressed fragment
+	 *  What was written before is compressed and fully flushed, then the
+	 *  compressed fragment is copied out as is and its check value combined with
+	 *  that of the rest of the stream. The full flush costs a few bytes, and the
+	 *  compressor cannot refer back past it; splicing pays off for fragments of
+	 *  more than a few hundred bytes.
+	 *  @param[in] f fragment
+	 *  @retval false if output failed
+	 */
+	bool splice(const Deflated_fragment& f);
+
+	/*! @brief Compress what is left and end the compressed stream
+	 *  Further output is an error.
+	 *  @retval false if output failed
+	 */
+	bool finish();
+
+	//! Number of bytes written to the filter so far
+	size_t bytes_in() const;
+
+	//! Number of compressed bytes written out so far
+	size_t bytes_out() const;
+
+protected:
+	int_type overflow(int_type c);
+	std::streamsize xsputn(const char* s, std::streamsize n);
+	int sync();
+
+private:
+	Deflate_filter(const Deflate_filter&) = delete;
+	Deflate_filter& operator = (const Deflate_filter&) = delete;
+
+	bool _deflate(int flush);
+	bool _write(const char* s, size_t n);
+
+	struct State;
+	std::unique_ptr<State> z;
+	std::streambuf* dest;
+	bool done;
+	bool error;
+	char buf[8192];
+	char out[16384];
+};
+
+/*! @brief Write a fragment
+ *  Splices in the compressed form if the stream's buffer is a Deflate_filter, and
+ *  writes the fragment as is otherwise.
+ *  @param[in,out] os stream
+ *  @param[in] f fragment
+ */
+std::ostream& operator << (std::ostream& os, const Deflated_fragment& f);
+
+/*! @brief Compress a response body, if the client accepts it
+ * Negotiates a coding from the request's Accept-Encoding, adds Content-Encoding
+ * (if compressing) and Vary to the header, writes the header, and compresses what
+ * is written to the stream for the lifetime of this object:
+ * @code
+ * const char* ae = getenv("HTTP_ACCEPT_ENCODING");
+ * header::Header h = header::content_type("text/html");
+ * http::Compressed_output z(cout, h, ae ? ae : "");
+ * cout << body;
+ * @endcode
+ * A header which already has a Content-Encoding is written as is, and the body is
+ * left alone.
+ *
+ * If the stream is a Response, nothing is written: the fields are added to its
+ * header (with @c h appended to it first, if @c h is another header), and the
+ * compressed body is buffered, so that its Content-Length is that of the coded
+ * body. A Response which has sent its header already is left uncompressed.
+ */
+class Compressed_output {
+public:
+	/*! @brief Write a header and compress what follows
+	 *  @param[in,out] os stream
+	 *  @param[in,out] h response header; Content-Encoding and Vary are added to it
+	 *  @param[in] accept_encoding the request's Accept-Encoding, or an empty view
+	 *  @param[in] level compression level; see Deflate_level
+	 *  @param[in] dictionary preset dictionary; only used with Coding::deflate,
+	 *    and only to be given to clients known to have it
+	 */
+	Compressed_output(std::ostream& os, header::Header& h, String_view accept_encoding,
+		int level = Deflate_level::standard, String_view dictionary = String_view());
+
+	//! Ends the compressed stream and restores the stream's buffer
+	~Compressed_output();
+
+	//! The coding in use; one of Coding
+	unsigned coding() const {
+		return _coding;
+	}
+
+	//! The filter, if compressing; a null pointer otherwise
+	const Deflate_filter* filter() const {
+		return _filter.get();
+	}
+
+private:
+	Compressed_output(const Compressed_output&) = delete;
+	Compressed_output& operator = (const Compressed_output&) = delete;
+
+	std::ostream& os;
+	unsigned _coding;
+	std::unique_ptr<Deflate_filter> _filter;
+	std::streambuf* saved;
+};
+
+}
+
+MOSH_CGI_END
+
+#endif
@@ -0,0 +1,145 @@
+//! @file mosh/cgi/http/etag.hpp Entity tags and conditional responses
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_HTTP_ETAG_HPP
+#define MOSH_CGI_HTTP_ETAG_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/bits/xxh64.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+/*! @brief Make a strong entity tag from a hash
+ *  @param[in] hash hash of the representation
+ *  @return the tag, quoted, e.g. "\"0123456789abcdef\""
+ */
+std::string make_etag(uint64_t hash);
+
+/*! @brief Make a strong entity tag for a body
+ *  @param[in] body representation
+ */
+inline std::string make_etag(String_view body) {
+	return make_etag(xxh64::hash(body.data(), body.size()));
+}
+
+/*! @brief Check an entity tag against If-None-Match
+ *  Uses the weak comparison, as RFC 7232 prescribes for If-None-Match: "W/" prefixes
+ *  are ignored. "*" matches any tag.
+ *  @param[in] if_none_match the request's If-None-Match, or an empty view
+ *  @param[in] etag entity tag, quoted
+ */
+bool etag_matches(String_view if_none_match, String_view etag);
+
+/*! @brief Output buffer which keeps the body and hashes it
+ * The body is hashed block by block as it is written, so that its entity tag is
+ * ready as soon as it is complete.
+ */
+class Etag_buffer : public std::streambuf {
+public:
+	Etag_buffer();
+
+	//! The body written so far
+	const std::string& body();
+
+	//! Entity tag of the body written so far
+	std::string etag();
+
+protected:
+	int_type overflow(int_type c);
+	std::streamsize xsputn(const char* s, std::streamsize n);
+	int sync();
+
+private:
+	Etag_buffer(const Etag_buffer&) = delete;
+	Etag_buffer& operator = (const Etag_buffer&) = delete;
+
+	void _drain();
+
+	xxh64::State hash;
+	std::string _body;
+	char buf[8192];
+};
+
+/*! @brief Answer a conditional request with 304 Not Modified
+ * Collects what is written to a stream for the lifetime of this object, then adds
+ * an ETag to the header and checks it against the request's If-None-Match. On a
+ * match, the response becomes a 304 with no body; otherwise the header and body are
+ * written as they are:
+ * @code
+ * const char* inm = getenv("HTTP_IF_NONE_MATCH");
+ * header::Header h = header::content_type("text/html");
+ * http::Etag_output e(cout, h, inm ? inm : "");
+ * cout << body;
+ * @endcode
+ * A header which has an ETag already keeps it, and it is that tag which is checked.
+ * Only a response with no Status or a 200 Status is made conditional; any other is
+ * written as is.
+ *
+ * If the stream is a Response, the header is not written: the ETag, and for a
+ * match the 304 Status, go into the Response's header (with @c h appended to it
+ * first, if @c h is another header), and the body is handed to the Response,
+ * which drops it for a 304.
+ */
+class Etag_output {
+public:
+	/*! @brief Collect a body to be sent conditionally
+	 *  @param[in,out] os stream
+	 *  @param[in,out] h response header; an ETag is added to it
+	 *  @param[in] if_none_match the request's If-None-Match, or an empty view
+	 */
+	Etag_output(std::ostream& os, header::Header& h, String_view if_none_match);
+
+	//! Calls finish()
+	~Etag_output();
+
+	/*! @brief Write the response
+	 *  Restores the stream's buffer and writes the header, and the body unless the
+	 *  response is a 304. Further calls do nothing.
+	 */
+	void finish();
+
+	//! Whether the response was turned into a 304; only known after finish()
+	bool not_modified() const {
+		return _not_modified;
+	}
+
+private:
+	Etag_output(const Etag_output&) = delete;
+	Etag_output& operator = (const Etag_output&) = delete;
+
+	std::ostream& os;
+	header::Header& h;
+	std::string if_none_match;
+	Etag_buffer buffer;
+	std::streambuf* saved;
+	bool _not_modified;
+};
+
+}
+
+MOSH_CGI_END
+
+#endif
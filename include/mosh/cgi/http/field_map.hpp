@@ -0,0 +1,399 @@
+//! @file mosh/cgi/http/field_map.hpp Case-insensitive map for header fields
+/*
+ * Copyright (C) 2011 m0shbear
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#ifndef MOSH_CGI_HTTP_FIELD_MAP_HPP
+#define MOSH_CGI_HTTP_FIELD_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+//! ASCII case folding; header field names are tokens, so nothing else needs folding
+constexpr char _field_fold(char c) {
+	return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/*! @brief Case-insensitive FNV-1a hash of a NUL-terminated field name
+ *  Usable in constant expressions, so that well-known names are hashed at compile time.
+ *  @param[in] s field name
+ *  @param[in] h running hash
+ */
+constexpr uint32_t field_hash(const char* s, uint32_t h = 2166136261u) {
+	return *s ? field_hash(s + 1, (h ^ static_cast<unsigned char>(_field_fold(*s))) * 16777619u) : h;
+}
+
+/*! @brief Case-insensitive FNV-1a hash of a field name
+ *  @param[in] s field name
+ *  @param[in] n length of @c s
+ */
+inline uint32_t field_hash(const char* s, size_t n) {
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < n; ++i)
+		h = (h ^ static_cast<unsigned char>(_field_fold(s[i]))) * 16777619u;
+	return h;
+}
+
+//! Compare two field names for equality, ignoring (ASCII) case
+inline bool field_equal(const char* s1, size_t n1, const char* s2, size_t n2) {
+	if (n1 != n2)
+		return false;
+	for (size_t i = 0; i < n1; ++i)
+		if (_field_fold(s1[i]) != _field_fold(s2[i]))
+			return false;
+	return true;
+}
+
+//! A pre-hashed field name
+struct Field_name {
+	//! Field name, in canonical case
+	const char* name;
+	//! Length of name
+	size_t size;
+	//! Value of field_hash(name)
+	uint32_t hash;
+
+	/*! @brief Create a pre-hashed field name from a string literal
+	 *  @param[in] s field name
+	 */
+	template <size_t N>
+	constexpr Field_name(const char (&s)[N])
+	: name(s), size(N - 1), hash(field_hash(s))
+	{ }
+};
+
+//! Pre-hashed well-known field names
+namespace field {
+	constexpr Field_name accept_encoding ("Accept-Encoding");
+	constexpr Field_name accept_ranges ("Accept-Ranges");
+	constexpr Field_name cache_control ("Cache-Control");
+	constexpr Field_name content_encoding ("Content-Encoding");
+	constexpr Field_name content_length ("Content-Length");
+	constexpr Field_name content_range ("Content-Range");
+	constexpr Field_name content_type ("Content-Type");
+	constexpr Field_name cookie ("Cookie");
+	constexpr Field_name etag ("ETag");
+	constexpr Field_name expires ("Expires");
+	constexpr Field_name host ("Host");
+	constexpr Field_name if_match ("If-Match");
+	constexpr Field_name if_modified_since ("If-Modified-Since");
+	constexpr Field_name if_none_match ("If-None-Match");
+	constexpr Field_name if_range ("If-Range");
+	constexpr Field_name last_modified ("Last-Modified");
+	constexpr Field_name location ("Location");
+	constexpr Field_name range ("Range");
+	constexpr Field_name set_cookie ("Set-Cookie");
+	constexpr Field_name status ("Status");
+	constexpr Field_name transfer_encoding ("Transfer-Encoding");
+	constexpr Field_name user_agent ("User-Agent");
+	constexpr Field_name vary ("Vary");
+}
+
+/*! @brief Open-addressing hash map keyed by case-insensitive field name
+ *
+ * Header blocks rarely have more than a couple dozen fields, so the table starts
+ * out with room for 32 slots and uses linear probing; it doubles when more than
+ * three quarters of the slots are taken. Names keep the spelling they were first
+ * inserted with.
+ * @tparam T value type
+ */
+template <typename T>
+class Field_map {
+	struct Slot {
+		bool used;
+		uint32_t hash;
+		std::string name;
+		T value;
+
+		Slot()
+		: used(false), hash(0), name(), value()
+		{ }
+	};
+public:
+	//! Iterator over used slots
+	template <typename Slot_iter, typename Value>
+	class Iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Value value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef Value* pointer;
+		typedef Value& reference;
+
+		Iterator(Slot_iter it_, Slot_iter end_)
+		: it(it_), end(end_)
+		{
+			skip();
+		}
+		//! Field name
+		const std::string& name() const { return it->name; }
+		//! Field value
+		Value& value() const { return it->value; }
+		//! Field value
+		Value& operator * () const { return it->value; }
+		//! Field value
+		Value* operator -> () const { return &it->value; }
+
+		Iterator& operator ++ () {
+			++it;
+			skip();
+			return *this;
+		}
+		Iterator operator ++ (int) {
+			Iterator i(*this);
+			operator ++ ();
+			return i;
+		}
+		bool operator == (const Iterator& i) const { return it == i.it; }
+		bool operator != (const Iterator& i) const { return it != i.it; }
+	private:
+		void skip() {
+			while (it != end && !it->used)
+				++it;
+		}
+		Slot_iter it;
+		Slot_iter end;
+	};
+	typedef Iterator<typename std::vector<Slot>::iterator, T> iterator;
+	typedef Iterator<typename std::vector<Slot>::const_iterator, const T> const_iterator;
+
+	/*! @brief Create an empty map
+	 *  @param[in] capacity initial number of slots; rounded up to a power of 2
+	 */
+	explicit Field_map(size_t capacity = 32)
+	: slots(_round_up(capacity)), count(0)
+	{ }
+
+	//! Number of fields in the map
+	size_t size() const { return count; }
+	//! Whether the map has no fields
+	bool empty() const { return count == 0; }
+
+	//! Remove all fields, keeping the allocated slots
+	void clear() {
+		for (auto& s : slots) {
+			if (s.used) {
+				s.used = false;
+				s.name.clear();
+				s.value = T();
+			}
+		}
+		count = 0;
+	}
+
+	/*! @name Lookup
+	 * Find a field by name; returns a null pointer if there is no such field.
+	 */
+	//@{
+	T* find(const char* name, size_t n, uint32_t hash) {
+		size_t i = _find(name, n, hash);
+		return (i == npos) ? nullptr : &slots[i].value;
+	}
+	const T* find(const char* name, size_t n, uint32_t hash) const {
+		size_t i = _find(name, n, hash);
+		return (i == npos) ? nullptr : &slots[i].value;
+	}
+	T* find(const Field_name& f) {
+		return find(f.name, f.size, f.hash);
+	}
+	const T* find(const Field_name& f) const {
+		return find(f.name, f.size, f.hash);
+	}
+	T* find(const std::string& s) {
+		return find(s.data(), s.size(), field_hash(s.data(), s.size()));
+	}
+	const T* find(const std::string& s) const {
+		return find(s.data(), s.size(), field_hash(s.data(), s.size()));
+	}
+	T* find(const char* s) {
+		size_t n = std::strlen(s);
+		return find(s, n, field_hash(s, n));
+	}
+	const T* find(const char* s) const {
+		size_t n = std::strlen(s);
+		return find(s, n, field_hash(s, n));
+	}
+	//@}
+
+	//! Whether a field is present
+	template <typename Name>
+	bool contains(const Name& name) const {
+		return find(name) != nullptr;
+	}
+
+	/*! @name Insertion
+	 * Get the value for a field, inserting a default-constructed value if absent.
+	 */
+	//@{
+	T& get(const char* name, size_t n, uint32_t hash) {
+		size_t i = _find(name, n, hash);
+		if (i != npos)
+			return slots[i].value;
+		if ((count + 1) * 4 > slots.size() * 3)
+			_grow();
+		i = _probe(hash);
+		Slot& s = slots[i];
+		s.used = true;
+		s.hash = hash;
+		s.name.assign(name, n);
+		++count;
+		return s.value;
+	}
+	T& operator [] (const Field_name& f) {
+		return get(f.name, f.size, f.hash);
+	}
+	T& operator [] (const std::string& s) {
+		return get(s.data(), s.size(), field_hash(s.data(), s.size()));
+	}
+	T& operator [] (const char* s) {
+		size_t n = std::strlen(s);
+		return get(s, n, field_hash(s, n));
+	}
+	//@}
+
+	/*! @name Removal
+	 * Remove a field; returns whether there was such a field.
+	 */
+	//@{
+	bool erase(const char* name, size_t n, uint32_t hash) {
+		size_t i = _find(name, n, hash);
+		if (i == npos)
+			return false;
+		// Backward-shift deletion keeps probe sequences intact without tombstones
+		const size_t mask = slots.size() - 1;
+		size_t j = i;
+		for (;;) {
+			j = (j + 1) & mask;
+			if (!slots[j].used)
+				break;
+			size_t home = slots[j].hash & mask;
+			if (((j - home) & mask) >= ((j - i) & mask)) {
+				std::swap(slots[i], slots[j]);
+				i = j;
+			}
+		}
+		slots[i].used = false;
+		slots[i].name.clear();
+		slots[i].value = T();
+		--count;
+		return true;
+	}
+	bool erase(const Field_name& f) {
+		return erase(f.name, f.size, f.hash);
+	}
+	bool erase(const std::string& s) {
+		return erase(s.data(), s.size(), field_hash(s.data(), s.size()));
+	}
+	bool erase(const char* s) {
+		size_t n = std::strlen(s);
+		return erase(s, n, field_hash(s, n));
+	}
+	//@}
+
+	/*! @name Iteration
+	 * Iteration order is unspecified.
+	 */
+	//@{
+	iterator begin() { return iterator(slots.begin(), slots.end()); }
+	iterator end() { return iterator(slots.end(), slots.end()); }
+	const_iterator begin() const { return const_iterator(slots.begin(), slots.end()); }
+	const_iterator end() const { return const_iterator(slots.end(), slots.end()); }
+	//@}
+
+private:
+	static const size_t npos = static_cast<size_t>(-1);
+
+	static size_t _round_up(size_t n) {
+		size_t c = 8;
+		while (c < n)
+			c <<= 1;
+		return c;
+	}
+
+	size_t _find(const char* name, size_t n, uint32_t hash) const {
+		const size_t mask = slots.size() - 1;
+		for (size_t i = hash & mask; slots[i].used; i = (i + 1) & mask) {
+			const Slot& s = slots[i];
+			if (s.hash == hash && field_equal(s.name.data(), s.name.size(), name, n))
+				return i;
+		}
+		return npos;
+	}
+
+	size_t _probe(uint32_t hash) const {
+		const size_t mask = slots.size() - 1;
+		size_t i = hash & mask;
+		while (slots[i].used)
+			i = (i + 1) & mask;
+		return i;
+	}
+
+	void _grow() {
+		std::vector<Slot> old(slots.size() * 2);
+		old.swap(slots);
+		for (auto& s : old) {
+			if (s.used)
+				slots[_probe(s.hash)] = std::move(s);
+		}
+	}
+
+	std::vector<Slot> slots;
+	size_t count;
+};
+
+/*! @brief Parse a block of "Name: value" lines
+ *  Lines without a colon (e.g. an HTTP status line) are skipped; repeated fields
+ *  are joined with ", ". Parsing stops after the first empty line.
+ *  @param[in] block header block
+ *  @param[in] n length of @c block
+ *  @param[in,out] fields map to add fields to
+ *  @return number of bytes consumed
+ */
+size_t parse_fields(const char* block, size_t n, Field_map<std::string>& fields);
+
+/*! @brief Parse a block of "Name: value" lines
+ *  @param[in] block header block
+ *  @param[in,out] fields map to add fields to
+ *  @return number of bytes consumed
+ *  @sa parse_fields(const char*, size_t, Field_map<std::string>&)
+ */
+inline size_t parse_fields(const std::string& block, Field_map<std::string>& fields) {
+	return parse_fields(block.data(), block.size(), fields);
+}
+
+/*! @brief Collect the request header fields passed through a CGI environment
+ *  Each HTTP_FOO_BAR variable becomes a Foo-Bar field; CONTENT_TYPE and
+ *  CONTENT_LENGTH are included as well.
+ *  @param[in] envp NULL-terminated environment block, as in @c environ
+ */
+Field_map<std::string> request_fields(const char* const* envp);
+
+}
+
+MOSH_CGI_END
+
+#endif
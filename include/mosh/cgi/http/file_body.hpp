@@ -0,0 +1,84 @@
+//! @file mosh/cgi/http/file_body.hpp Response bodies sent from files
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_HTTP_FILE_BODY_HPP
+#define MOSH_CGI_HTTP_FILE_BODY_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <mosh/cgi/bits/namespace.hpp>
+
+extern "C" {
+#include <sys/types.h>
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+/*! @brief Part of a file, to be written to a response as it is
+ * Written to a Response, the range is not read: it takes its place in the body
+ * and is sent from the file, after the header and whatever comes before it, with
+ * splice(2) if the destination is a pipe and sendfile(2) otherwise. Where neither
+ * works, or the response has been filtered, the file is mapped and written out
+ * from the mapping. Either way the data does not pass through a buffer of ours.
+ * @code
+ * int fd = open("report.pdf", O_RDONLY);
+ * http::Response r(STDOUT_FILENO);
+ * r.header += header::content_type("application/pdf");
+ * r << http::File_body(fd);
+ * r.finish();
+ * close(fd);
+ * @endcode
+ * The file descriptor is not owned: it has to stay open, and the range unchanged,
+ * until the response is finished.
+ */
+struct File_body {
+	/*! @brief Refer to part of a file
+	 *  @param[in] fd_ file descriptor of a regular file
+	 *  @param[in] offset_ start of the part
+	 *  @param[in] size_ length of the part
+	 */
+	File_body(int fd_, off_t offset_, size_t size_)
+	: fd(fd_), offset(offset_), size(size_)
+	{ }
+
+	/*! @brief Refer to the whole of a file
+	 *  @param[in] fd_ file descriptor of a regular file
+	 *  @throw std::invalid_argument if fd_ is not open on a regular file
+	 */
+	explicit File_body(int fd_);
+
+	int fd;
+	off_t offset;
+	size_t size;
+};
+
+/*! @brief Write part of a file
+ *  To a Response, this defers the data to when the body is sent, as above; to any
+ *  other stream, it writes the data from a mapping of the file.
+ *  @param[in,out] os stream
+ *  @param[in] f file part
+ */
+std::ostream& operator << (std::ostream& os, const File_body& f);
+
+}
+
+MOSH_CGI_END
+
+#endif
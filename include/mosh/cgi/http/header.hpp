@@ -21,6 +21,7 @@
 #ifndef MOSH_CGI_HTTP_HEADER_HPP
 #define MOSH_CGI_HTTP_HEADER_HPP
 
+#include <cstdint>
 #include <initializer_list>
 #include <map>
 #include <stdexcept>
@@ -29,11 +30,13 @@
 #include <vector>
 
 #include <mosh/cgi/http/cookie.hpp>
+#include <mosh/cgi/http/field_map.hpp>
 #include <mosh/cgi/http/helpers/helper.hpp>
 #include <mosh/cgi/http/helpers/content_type.hpp>
 #include <mosh/cgi/http/helpers/redirect.hpp>
 #include <mosh/cgi/http/helpers/response.hpp>
 #include <mosh/cgi/http/helpers/status.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
 #include <mosh/cgi/bits/namespace.hpp>
 
 MOSH_CGI_BEGIN
@@ -48,26 +51,38 @@ public:
 
 	//! Default constructor
 	Header()
+	: indexed(0)
 	{ }
 
 	//! Helper constructor
 	Header(const Helper& h)
-	: helper(h)
+	: helper(h), indexed(0)
 	{ }
 
 	//! Copy constructor
 	Header(const Header& h)
-	: helper(h.helper), data(h.data)
+	: helper(h.helper), data(h.data), fields(h.fields), indexed(h.indexed)
 	{ }
 
 	//! Move constructor
 	Header(Header&& h)
-	: helper(h.helper), data(std::move(h.data))
+	: helper(h.helper), data(std::move(h.data)), fields(std::move(h.fields)), indexed(h.indexed)
 	{ }
 
 	virtual ~Header()
 	{ }
 
+	/*! @brief Remove all fields and cookies, keeping the helper
+	 *  The buffers keep their capacity, so a header can be reused from one
+	 *  request to the next without allocating.
+	 */
+	void clear() {
+		cookies.clear();
+		data.clear();
+		fields.clear();
+		indexed = 0;
+	}
+
 	/*! @name Function-call overloads
 	 * These overloads are wrappers for the functions described in @c Helper
 	 * @sa Helper
@@ -254,10 +269,10 @@ public:
 	 */
 	//@{
 	/*! @brief Append a complete header line
-	 *  @param[in] s line to append
+	 *  @param[in] s line to append (a string, a literal or a view)
 	 */
-	Header& operator += (const std::string& s) {
-		data += s;
+	Header& operator += (String_view s) {
+		data.append(s.data(), s.size());
 		check_crlf();
 		return *this;
 	}
@@ -273,6 +288,84 @@ public:
 		return *this;
 	}
 	
+	/*! @brief Append another header, as rendered
+	 *  @param[in] h header to append
+	 */
+	Header& operator += (const Header& h) {
+		const std::string s = h;
+		return *this += String_view(s);
+	}
+
+	/*! @brief Append a name: value header line
+	 *  Unlike appending a pair, this builds no temporary strings.
+	 *  @param[in] name field name
+	 *  @param[in] value field value
+	 */
+	Header& append(String_view name, String_view value) {
+		data.append(name.data(), name.size());
+		data += ": ";
+		data.append(value.data(), value.size());
+		check_crlf();
+		return *this;
+	}
+	
+	/*! @brief Set a field, replacing any lines it has already
+	 *  @param[in] name field name
+	 *  @param[in] value field value
+	 */
+	Header& set(String_view name, String_view value) {
+		erase(name);
+		return append(name, value);
+	}
+
+	/*! @brief Remove every line of a field
+	 *  @param[in] name field name
+	 *  @return whether the field was set
+	 */
+	bool erase(String_view name) {
+		bool found = false;
+		for (size_t pos = 0; pos < data.size(); ) {
+			const size_t eol = data.find("\r\n", pos);
+			const size_t next = (eol == std::string::npos) ? data.size() : eol + 2;
+			if (next - pos > name.size() && data[pos + name.size()] == ':'
+					&& field_equal(data.data() + pos, name.size(), name.data(), name.size())) {
+				data.erase(pos, next - pos);
+				found = true;
+			} else {
+				pos = next;
+			}
+		}
+		if (found) {
+			fields.erase(std::string(name.data(), name.size()));
+			indexed = data.size();
+		}
+		return found;
+	}
+
+	/*! @brief Advertise byte ranges
+	 *  Sets Accept-Ranges: bytes.
+	 */
+	Header& accept_ranges() {
+		return set(field::accept_ranges.name, "bytes");
+	}
+
+	/*! @brief Set the Content-Range of a 206 response, or a part of one
+	 *  @param[in] first offset of the first byte sent
+	 *  @param[in] last offset of the last byte sent
+	 *  @param[in] complete length of the whole representation
+	 */
+	Header& content_range(uint64_t first, uint64_t last, uint64_t complete) {
+		return set(field::content_range.name, "bytes " + std::to_string(first) + '-'
+			+ std::to_string(last) + '/' + std::to_string(complete));
+	}
+
+	/*! @brief Set the Content-Range of a 416 response
+	 *  @param[in] complete length of the whole representation
+	 */
+	Header& content_range(uint64_t complete) {
+		return set(field::content_range.name, "bytes */" + std::to_string(complete));
+	}
+
 	/*! @brief Append complete header line(s)
 	 *  @param[in] h {}-list of line(s) to append
 	 */
@@ -294,18 +387,52 @@ public:
 		return *this;
 	}
 	//@}
+
+	/*! @name Field lookup
+	 * Case-insensitive lookup of the fields added so far, whether appended as
+	 * lines, as pairs or by a helper.
+	 * @note Cookies are kept separately; see @c cookies
+	 */
+	//@{
+	/*! @brief Get the value of a field
+	 *  @param[in] f field name (a @c Field_name constant or a string)
+	 *  @return the field value, or a null pointer if the field has not been set
+	 */
+	template <typename Name>
+	const std::string* find(const Name& f) const {
+		return fields.find(f);
+	}
+
+	/*! @brief Check whether a field has been set
+	 *  @param[in] f field name (a @c Field_name constant or a string)
+	 */
+	template <typename Name>
+	bool has(const Name& f) const {
+		return fields.contains(f);
+	}
+	//@}
 	
-	//! String cast operator
-	operator std::string () const {
-		std::stringstream ss;
-		ss << data;
+	/*! @brief Render the header block, appending it to a string
+	 *  Cookies follow the other fields, one Set-Cookie line each, and the block
+	 *  ends with an empty line.
+	 *  @param[in,out] s string to append to
+	 */
+	void render(std::string& s) const {
+		s += data;
 		for (const auto& cookie_k : cookies) {
 			for (const auto& cookie_v : cookie_k.second) {
-				ss << cookie_v << std::endl;
+				s += cookie_v.operator std::string();
+				s += "\r\n";
 			}
 		}
-		ss << "\r\n";
-		return ss.str();
+		s += "\r\n";
+	}
+
+	//! String cast operator
+	operator std::string () const {
+		std::string s;
+		render(s);
+		return s;
 	}
 
 	//! String cast operator
@@ -317,6 +444,11 @@ public:
 	Helper helper;
 private:
 	std::string data;
+	//! Index of the fields in data
+	Field_map<std::string> fields;
+	//! Length of the prefix of data that has been indexed
+	size_t indexed;
+
 	void check_crlf() {
 		auto _e = data.cend();
 		if (!(*(_e - 2) == '\r' && *(_e - 1) == '\n'))
@@ -325,6 +457,8 @@ private:
 		if ((_n = data.find("\r\n\r\n")) != std::string::npos) {
 			data.erase(_n + 2);
 		}
+		if (indexed < data.size())
+			indexed += parse_fields(data.data() + indexed, data.size() - indexed, fields);
 	}
 			
 };
@@ -338,7 +472,7 @@ private:
  *  @param[in] _h header
  *  @param[in] _s line to append
  */
-Header operator + (const Header& _h, const std::string& _s) {
+inline Header operator + (const Header& _h, String_view _s) {
 	Header h(_h);
 	h += _s;
 	return h;
@@ -348,17 +482,37 @@ Header operator + (const Header& _h, const std::string& _s) {
  *  @param[in] _h header
  *  @param[in] _s line to concatenate
  */
-Header operator + (Header&& _h, const std::string& _s) {
+inline Header operator + (Header&& _h, String_view _s) {
 	Header h(std::move(_h));
 	h += _s;
 	return std::move(h);
 }
 
+/*! @brief Concatenate another header
+ *  @param[in] _h header
+ *  @param[in] _o header to concatenate
+ */
+inline Header operator + (const Header& _h, const Header& _o) {
+	Header h(_h);
+	h += _o;
+	return h;
+}
+
+/*! @brief Concatenate another header
+ *  @param[in] _h header
+ *  @param[in] _o header to concatenate
+ */
+inline Header operator + (Header&& _h, const Header& _o) {
+	Header h(std::move(_h));
+	h += _o;
+	return h;
+}
+
 /*! @brief Concatenate a name: value header line
  *  @param[in] _h header
  *  @param[in] _p header pair to concatenate
  */
-Header operator + (const Header& _h, const std::pair<std::string, std::string>& _p) {
+inline Header operator + (const Header& _h, const std::pair<std::string, std::string>& _p) {
 	Header h(_h);
 	h += _p;
 	return h;
@@ -368,7 +522,7 @@ Header operator + (const Header& _h, const std::pair<std::string, std::string>&
  *  @param[in] _h header
  *  @param[in] _p header pair to concatenate
  */
-Header operator + (Header&& _h, const std::pair<std::string, std::string>& _p) {
+inline Header operator + (Header&& _h, const std::pair<std::string, std::string>& _p) {
 	Header h(_h);
 	h += _p;
 	return std::move(h);
@@ -378,17 +532,17 @@ Header operator + (Header&& _h, const std::pair<std::string, std::string>& _p) {
  *  @param[in] _h header
  *  @param[in]_hl {}-list of header lines to concatenate
  */
-Header operator + (const Header& _h, std::initializer_list<std::string> _hl) {
+inline Header operator + (const Header& _h, std::initializer_list<std::string> _hl) {
 	Header h(_h);
 	h += _hl;
-	return _h;
+	return h;
 }
 
 /*! @brief Concatenate complete header line(s)
  *  @param[in] _h header
  *  @param[in]_hl {}-list of header lines to concatenate
  */
-Header operator + (Header&& _h, std::initializer_list<std::string> _hl) {
+inline Header operator + (Header&& _h, std::initializer_list<std::string> _hl) {
 	Header h(std::move(_h));
 	h += _hl;
 	return std::move(h);
@@ -398,7 +552,7 @@ Header operator + (Header&& _h, std::initializer_list<std::string> _hl) {
  *  @param[in] _h header
  *  @param[in] _hp {}-list of header pairs to concatenate
  */
-Header operator + (const Header& _h, std::initializer_list<std::pair<std::string, std::string>> _hp) {
+inline Header operator + (const Header& _h, std::initializer_list<std::pair<std::string, std::string>> _hp) {
 	Header h(_h);
 	h += _hp;
 	return h;
@@ -408,27 +562,82 @@ Header operator + (const Header& _h, std::initializer_list<std::pair<std::string
  *  @param[in] _h header
  *  @param[in] _hp {}-list of header pairs to concatenate
  */
-Header operator + (Header&& _h, std::initializer_list<std::pair<std::string, std::string>> _hp) {
+inline Header operator + (Header&& _h, std::initializer_list<std::pair<std::string, std::string>> _hp) {
 	Header h(std::move(_h));
 	h += _hp;
 	return std::move(h);
 }	
 //@}
 
-std::pair<std::string, std::string> P(std::string&& s1, std::string&& s2) {
+inline std::pair<std::string, std::string> P(std::string&& s1, std::string&& s2) {
 	return std::make_pair(std::move(s1), std::move(s2));
 }
-std::pair<std::string, std::string> P(const std::string& s1, const std::string& s2) {
+inline std::pair<std::string, std::string> P(const std::string& s1, const std::string& s2) {
 	return std::make_pair(s1, s2);
 }
 
+/*! @brief Header prototype
+ * A literal type naming a helper. Prototypes are constant-initialized, so the
+ * predefined headers run no code before @c main; the Header itself is only built
+ * when the prototype is called or converted.
+ */
+class Header_prototype {
+public:
+	/*! @brief Create a prototype for headers using a given helper
+	 *  @param[in] make_helper_ helper factory
+	 */
+	constexpr Header_prototype(Helper (*make_helper_)())
+	: make_helper(make_helper_)
+	{ }
+
+	//! Create the header
+	operator Header () const {
+		return Header(make_helper());
+	}
+
+	/*! @name Function-call overloads
+	 * These overloads create a header and call it with the given arguments.
+	 * @sa Header
+	 */
+	//@{
+	Header operator () (unsigned u) const {
+		Header h(make_helper());
+		h(u);
+		return h;
+	}
+	Header operator () (const std::string& s) const {
+		Header h(make_helper());
+		h(s);
+		return h;
+	}
+	Header operator () (unsigned u, const std::string& s) const {
+		Header h(make_helper());
+		h(u, s);
+		return h;
+	}
+	Header operator () (const std::string& s, unsigned u) const {
+		Header h(make_helper());
+		h(s, u);
+		return h;
+	}
+	Header operator () (const std::string& s1, const std::string& s2) const {
+		Header h(make_helper());
+		h(s1, s2);
+		return h;
+	}
+	//@}
+
+	//! Helper factory
+	Helper (*make_helper)();
+};
+
 /*! @name Predefined headers
  */
 //@{
-const Header content_type (helpers::content_type::helper());
-const Header redirect (helpers::redirect::helper());
-const Header response (helpers::response::helper());
-const Header status (helpers::status::helper());
+constexpr Header_prototype content_type (helpers::content_type::helper);
+constexpr Header_prototype redirect (helpers::redirect::helper);
+constexpr Header_prototype response (helpers::response::helper);
+constexpr Header_prototype status (helpers::status::helper);
 //@}
 
 }
@@ -41,6 +41,13 @@ namespace status {
  *  @sa status_helper
  */
 std::string print_status (unsigned st);
+
+/*! @brief Set the status of a rendered header block
+ *  Replaces the Status line if there is one, and prepends one otherwise.
+ *  @param[in,out] head header block, as rendered by @c Header
+ *  @param[in] st HTTP status code
+ */
+void set_status (std::string& head, unsigned st);
 	
 //! Create a helper consisting of Status line generators 
 Helper helper();
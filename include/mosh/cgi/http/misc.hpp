@@ -22,7 +22,11 @@
 #ifndef MOSH_CGI_HTTP_MISC_HPP
 #define MOSH_CGI_HTTP_MISC_HPP
 
+#include <cstddef>
+#include <cstring>
+#include <ctime>
 #include <string>
+#include <mosh/cgi/bits/string_view.hpp>
 #include <mosh/cgi/bits/namespace.hpp>
 
 MOSH_CGI_BEGIN
@@ -33,6 +37,202 @@ namespace http {
 //! Prints the current UTC time, in microsecond resolution to a string, with format fmt
 std::string time_to_string(const std::string& fmt, unsigned long add_seconds);
 
+/*! @name HTTP dates
+ * Dates are written in the preferred IMF-fixdate format, e.g.
+ * "Sun, 06 Nov 1994 08:49:37 GMT", and read in any of the three formats of
+ * RFC 7231, 7.1.1.1. Both work in UTC and are independent of the locale.
+ */
+//@{
+//! Length of a date in IMF-fixdate format
+const size_t http_date_size = 29;
+
+/*! @brief Format an HTTP date
+ *  @param[out] out buffer of at least http_date_size bytes; not NUL-terminated
+ *  @param[in] t time
+ */
+void format_http_date(char* out, time_t t);
+
+/*! @brief Format an HTTP date
+ *  @param[in] t time
+ */
+std::string http_date(time_t t);
+
+/*! @brief Parse an HTTP date
+ *  @param[in] s date, in IMF-fixdate, RFC 850 or asctime format
+ *  @param[out] t time
+ *  @retval false if s is not a valid date, in which case t is unchanged
+ */
+bool parse_http_date(String_view s, time_t& t);
+//@}
+
+//! Percent-encoding modes
+namespace Percent {
+	/*! @brief A URI component (RFC 3986), e.g. a query value or a path segment
+	 * Everything but ALPHA, DIGIT and "-._~" is encoded.
+	 */
+	const unsigned component = 0;
+	//! As component, but a space is encoded as '+' (application/x-www-form-urlencoded)
+	const unsigned form = 1;
+	/*! @brief A whole URI, e.g. a Location or an href
+	 * Reserved characters and '%' are kept, so encoding a valid URI leaves it
+	 * unchanged; spaces, controls, non-ASCII bytes and "\"<>\\^`{|}" are encoded.
+	 */
+	const unsigned uri = 2;
+}
+
+/*! @name Percent-encoding
+ * The encoders and decoders write into a caller buffer and return the number of
+ * bytes written; the std::string overloads append. Runs of bytes which need no
+ * change are found 16 or 32 bytes at a time with SSE2 or AVX2, picked at run time
+ * (see cpu::select), or else with a table lookup per byte (memchr() when decoding
+ * outside form mode), and copied in one go, so mostly-plain input costs little
+ * more than a copy.
+ */
+//@{
+//! Largest output of percent_encode() for n input bytes
+constexpr size_t percent_encoded_max(size_t n) {
+	return 3 * n;
+}
+
+/*! @brief Percent-encode
+ *  @param[out] out buffer of at least percent_encoded_max(in.size()) bytes
+ *  @param[in] in input
+ *  @param[in] mode one of Percent
+ *  @return number of bytes written
+ */
+size_t percent_encode(char* out, String_view in, unsigned mode = Percent::component);
+
+/*! @brief Percent-encode, appending to a string
+ *  @param[in,out] out string to append to
+ *  @param[in] in input
+ *  @param[in] mode one of Percent
+ */
+void percent_encode(std::string& out, String_view in, unsigned mode = Percent::component);
+
+/*! @brief Percent-decode
+ *  A '%' which is not followed by two hex digits is copied as is. Decoding in
+ *  place (out == in.data()) is allowed.
+ *  @param[out] out buffer of at least in.size() bytes
+ *  @param[in] in input
+ *  @param[in] mode Percent::form to decode '+' as a space
+ *  @return number of bytes written
+ */
+size_t percent_decode(char* out, String_view in, unsigned mode = Percent::component);
+
+/*! @brief Percent-decode, appending to a string
+ *  @param[in,out] out string to append to
+ *  @param[in] in input
+ *  @param[in] mode Percent::form to decode '+' as a space
+ */
+void percent_decode(std::string& out, String_view in, unsigned mode = Percent::component);
+//@}
+
+//! Base64 alphabets (RFC 4648)
+namespace Base64 {
+	//! "+/", with '=' padding
+	const unsigned standard = 0;
+	//! "-_", without padding; safe in URLs, file names and cookie values
+	const unsigned url = 1;
+}
+
+/*! @name Base64
+ * As with percent-encoding, the encoders and decoders write into a caller buffer
+ * and return the number of bytes written, and the std::string overloads append.
+ * With AVX2, 24 bytes are encoded (and 32 characters decoded) per step with
+ * vector shuffles, picked at run time (see cpu::select); otherwise three bytes
+ * (four characters) are handled per step through lookup tables, with no
+ * per-byte branches.
+ */
+//@{
+//! Length of the output of base64_encode() for n input bytes
+constexpr size_t base64_encoded_size(size_t n, unsigned alphabet = Base64::standard) {
+	return (alphabet == Base64::url) ? (4 * n + 2) / 3 : 4 * ((n + 2) / 3);
+}
+
+//! Largest output of base64_decode() for n input characters
+constexpr size_t base64_decoded_max(size_t n) {
+	return 3 * (n / 4) + (3 * (n % 4)) / 4;
+}
+
+/*! @brief Base64-encode
+ *  @param[out] out buffer of at least base64_encoded_size(in.size(), alphabet) bytes
+ *  @param[in] in input
+ *  @param[in] alphabet one of Base64
+ *  @return number of bytes written
+ */
+size_t base64_encode(char* out, String_view in, unsigned alphabet = Base64::standard);
+
+/*! @brief Base64-encode, appending to a string
+ *  @param[in,out] out string to append to
+ *  @param[in] in input
+ *  @param[in] alphabet one of Base64
+ */
+void base64_encode(std::string& out, String_view in, unsigned alphabet = Base64::standard);
+
+/*! @brief Base64-decode
+ *  Either alphabet is accepted, with or without padding.
+ *  @param[out] out buffer of at least base64_decoded_max(in.size()) bytes
+ *  @param[in] in input
+ *  @return number of bytes written
+ *  @throw std::invalid_argument if in is not valid base64
+ */
+size_t base64_decode(char* out, String_view in);
+
+/*! @brief Base64-decode, appending to a string
+ *  @param[in,out] out string to append to
+ *  @param[in] in input
+ *  @throw std::invalid_argument if in is not valid base64
+ */
+void base64_decode(std::string& out, String_view in);
+//@}
+
+/*! @brief Splitter for application/x-www-form-urlencoded data
+ * Yields the name/value pairs of a query string or form body, still encoded
+ * (pass them to percent_decode() with Percent::form), as views into the input.
+ * Pairs are separated by '&' or ';'; empty pairs are skipped and a pair without
+ * '=' has an empty value.
+ * @code
+ * http::Form_splitter f(query);
+ * for (String_view n, v; f.next(n, v); ) ...
+ * @endcode
+ */
+class Form_splitter {
+public:
+	/*! @brief Split a query string or form body
+	 *  @param[in] in input, which must outlive the splitter
+	 */
+	explicit Form_splitter(String_view in)
+	: p(in.begin()), e(in.end())
+	{ }
+
+	/*! @brief Get the next pair
+	 *  @param[out] name name, still encoded
+	 *  @param[out] value value, still encoded
+	 *  @retval false if there are no more pairs
+	 */
+	bool next(String_view& name, String_view& value) {
+		while (p != e) {
+			const char* q = p;
+			while (q != e && *q != '&' && *q != ';')
+				++q;
+			const char* b = p;
+			p = (q == e) ? e : q + 1;
+			if (q == b)
+				continue;
+			const void* eq = std::memchr(b, '=', q - b);
+			const char* m = (eq == nullptr) ? q : static_cast<const char*>(eq);
+			name = String_view(b, m - b);
+			value = (m == q) ? String_view(q, 0) : String_view(m + 1, q - m - 1);
+			return true;
+		}
+		return false;
+	}
+
+private:
+	const char* p;
+	const char* e;
+};
+
 }
 
 MOSH_CGI_END
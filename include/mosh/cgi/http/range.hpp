@@ -0,0 +1,66 @@
+//! @file mosh/cgi/http/range.hpp Byte range requests
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_HTTP_RANGE_HPP
+#define MOSH_CGI_HTTP_RANGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+//! A range of bytes, resolved against the length of the representation
+struct Byte_range {
+	//! Offset of the first byte
+	uint64_t first;
+	//! Offset of the last byte, inclusive
+	uint64_t last;
+
+	//! Number of bytes
+	uint64_t size() const {
+		return last - first + 1;
+	}
+};
+
+//! Most ranges answered in one response; a request for more gets the whole representation
+const size_t max_ranges = 64;
+
+/*! @brief Parse a Range field
+ *  Follows RFC 7233: a list of "first-last", "first-" and "-suffix" byte ranges
+ *  in the "bytes" unit. Ranges which start past the end are left out; the rest
+ *  are clipped to the representation, sorted, and merged where they overlap or
+ *  touch, so that no byte is sent twice.
+ *  @param[in] value field value, e.g. "bytes=0-499,-500"
+ *  @param[in] length length of the representation
+ *  @param[out] ranges the satisfiable ranges
+ *  @return 206 if there are satisfiable ranges, 416 if there are none, and 0 if
+ *    the field is to be ignored and the whole representation sent: it is empty,
+ *    malformed, in another unit, or asks for more than max_ranges ranges
+ */
+unsigned parse_range(String_view value, uint64_t length, std::vector<Byte_range>& ranges);
+
+}
+
+MOSH_CGI_END
+
+#endif
@@ -0,0 +1,275 @@
+//! @file mosh/cgi/http/response.hpp Buffered response with Content-Length
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_HTTP_RESPONSE_HPP
+#define MOSH_CGI_HTTP_RESPONSE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <mosh/cgi/http/file_body.hpp>
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/http/range.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/uio.h>
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+//! What a Response does with a body which outgrows its threshold
+namespace Overflow {
+	//! Send the header, without a Content-Length, and stream the rest of the body
+	const unsigned stream = 0;
+	//! Go on buffering in a temporary file, and stream only if none can be made
+	const unsigned spill = 1;
+}
+
+/*! @brief A response: a header and a buffered body
+ * The body is written to the response, which is a stream, and kept in a buffer
+ * until finish(). The header is complete by then, so a Content-Length is added and
+ * the header and body go out together:
+ * @code
+ * http::Response r(cout);
+ * r.header += header::content_type("text/html");
+ * r << s::html_begin(rev) << ... << s::html_end();
+ * r.finish();
+ * @endcode
+ * A body which outgrows the threshold is not buffered any further: the header is
+ * sent then, without a Content-Length, and the body is streamed from there on.
+ * With Overflow::spill, it goes on being buffered, but in an unlinked temporary
+ * file rather than in memory; finish() then sends the file with sendfile(2), so
+ * that a large body still has a Content-Length while memory use stays bounded by
+ * the threshold.
+ *
+ * A response can also go straight to a file descriptor, such as standard output
+ * of a CGI program. The header block and body are then sent with one writev(2),
+ * so that a buffered response costs one system call, or as few as the pipe or
+ * socket takes to accept it all. Anything written to the descriptor through other
+ * means, such as @c cout, has to be flushed first.
+ *
+ * A response whose Status is 1xx, 204 or 304 is sent without a body, even if one
+ * was written to it; Etag_output and send_deferred() rely on that to turn a
+ * buffered response into a 304.
+ *
+ * In a persistent worker, one Response can serve every request: reset() clears
+ * the header and body but keeps the buffer, which after the first few requests is
+ * large enough not to be reallocated again.
+ */
+class Response : public std::ostream {
+public:
+	//! Default body size beyond which a response is streamed
+	static const size_t default_threshold = 1 << 20;
+
+	/*! @brief Start a response
+	 *  @param[in,out] out stream to send the response to
+	 *  @param[in] threshold body size beyond which the body is streamed or spilled
+	 *  @param[in] overflow what to do past the threshold, from Overflow
+	 */
+	explicit Response(std::ostream& out, size_t threshold = default_threshold,
+		unsigned overflow = Overflow::stream);
+
+	/*! @brief Start a response
+	 *  @param[in] fd file descriptor to send the response to
+	 *  @param[in] threshold body size beyond which the body is streamed or spilled
+	 *  @param[in] overflow what to do past the threshold, from Overflow
+	 */
+	explicit Response(int fd, size_t threshold = default_threshold,
+		unsigned overflow = Overflow::stream);
+
+	//! Calls finish()
+	~Response();
+
+	//! The response header; may be changed until the response is committed
+	header::Header header;
+
+	/*! @brief Send what is left of the response
+	 *  Further calls do nothing until reset().
+	 *  @retval false if output failed
+	 */
+	bool finish();
+
+	/*! @brief Start another response
+	 *  The current one is finished first. The header and body are cleared, keeping
+	 *  the capacity of their buffers.
+	 *  @param[in,out] out stream to send the next response to
+	 */
+	void reset(std::ostream& out);
+
+	/*! @brief Start another response
+	 *  @param[in] fd file descriptor to send the next response to
+	 *  @sa reset(std::ostream&)
+	 */
+	void reset(int fd);
+
+	//! Start another response on the same stream or file descriptor
+	void reset();
+
+	/*! @brief Add part of a file to the body
+	 *  The part counts towards the Content-Length but not the threshold: it is not
+	 *  read, but sent from the file in its place when the body goes out. If the
+	 *  stream has been filtered, as by Compressed_output, it is written through the
+	 *  filter instead.
+	 *  @retval false if output failed
+	 *  @sa File_body
+	 */
+	bool append(const File_body& f);
+
+	/*! @brief Add data to the body without copying it
+	 *  The data is not copied into the buffer but sent from where it is, in the
+	 *  same writev() as what comes before it; @c keep holds it until then.
+	 *  @param[in] v data
+	 *  @param[in] keep owner of the data, such as a mapping
+	 *  @retval false if output failed
+	 *  @sa html::Mapped_text
+	 */
+	bool append(String_view v, std::shared_ptr<const void> keep);
+
+	/*! @brief Answer Range requests
+	 *  A complete response with no Status, or a 200 Status, gets Accept-Ranges:
+	 *  bytes, and if @c range is a valid Range field, only what it asks for: one
+	 *  range as a 206 with a Content-Range, several as a 206 multipart/byteranges,
+	 *  and none that can be satisfied as a 416. The ranges are sent from where the
+	 *  body is, whether in the buffer, the spill file or the parts added with
+	 *  append(), without being copied. A response streamed for want of a known
+	 *  length is sent whole; Overflow::spill keeps large bodies rangeable.
+	 *  @code
+	 *  http::Response r(STDOUT_FILENO, http::Response::default_threshold, http::Overflow::spill);
+	 *  r.header += header::content_type("text/csv");
+	 *  v.add_to(r.header);
+	 *  r.ranges(v.range(c));
+	 *  @endcode
+	 *  @param[in] range the request's Range field, or an empty view to advertise ranges only
+	 *  @sa Validators::range
+	 */
+	void ranges(String_view range);
+
+	//! Size of the body written so far
+	size_t size() const {
+		return buf.size();
+	}
+
+	//! Whether the header has been sent
+	bool committed() const {
+		return buf.committed;
+	}
+
+	//! Capacity of the body buffer
+	size_t capacity() const {
+		return buf.store.size();
+	}
+
+private:
+	Response(const Response&) = delete;
+	Response& operator = (const Response&) = delete;
+
+	//! Body buffer; streams to the destination once committed
+	class Buffer : public std::streambuf {
+	public:
+		Buffer(Response& r_, size_t threshold_, unsigned overflow_);
+		~Buffer();
+		size_t size() const;
+		void clear();
+		bool drain(const char* s = nullptr, size_t n = 0);
+		bool write_out(bool to_file, const char* h, size_t hn, const char* s, size_t n);
+		bool append(const File_body& f);
+		bool append(String_view v, std::shared_ptr<const void>&& keep);
+
+		//! A piece of the body: in memory, or if data is null, in a file
+		struct Piece {
+			const char* data;
+			int fd;
+			off_t offset;
+			size_t size;
+		};
+
+		//! A piece kept out of the buffer, and where in the buffer it goes
+		struct Part {
+			size_t at;
+			Piece piece;
+			std::shared_ptr<const void> keep;
+		};
+
+		void pieces(std::vector<Piece>& v, bool with_spilled) const;
+		static void slice(const std::vector<Piece>& v, uint64_t first, uint64_t n, std::vector<Piece>& out);
+		bool put(bool to_file, const Piece* p, size_t n);
+		void consumed(bool to_file, size_t n);
+
+		Response& r;
+		size_t threshold;
+		unsigned overflow_mode;
+		std::string store;
+		std::vector<Part> parts;
+		size_t parts_size;
+		//! Pieces and blocks gathered for output, kept for their capacity
+		std::vector<Piece> chunks;
+		std::vector<iovec> iov;
+		//! Body bytes already sent
+		size_t sent;
+		//! Spill file, kept across responses, and the body bytes in it
+		int file;
+		size_t spilled;
+		bool committed;
+		bool error;
+
+	protected:
+		int_type overflow(int_type c);
+		std::streamsize xsputn(const char* s, std::streamsize n);
+		int sync();
+
+	private:
+		bool _make_room(size_t n);
+		bool _spill(const char* s, size_t n);
+		void _bump(size_t n);
+	};
+
+	bool _commit(bool complete);
+	bool _commit_ranges();
+	bool _send(iovec* v, int n);
+	bool _send_file(int in, off_t offset, size_t n);
+
+	//! Destination: a stream, or if null, a file descriptor
+	std::ostream* out;
+	int fd;
+	//! Rendered header block
+	std::string head;
+	Buffer buf;
+	bool finished;
+	//! Range handling: whether to, the Range to answer, and the parts of the answer
+	bool accept_ranges;
+	std::string range;
+	std::vector<Byte_range> byte_ranges;
+	std::vector<Buffer::Piece> slices;
+	std::string part_heads;
+	std::vector<size_t> part_marks;
+};
+
+}
+
+MOSH_CGI_END
+
+#endif
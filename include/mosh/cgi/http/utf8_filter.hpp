@@ -0,0 +1,149 @@
+//! @file mosh/cgi/http/utf8_filter.hpp UTF-8 checking output stage
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifndef MOSH_CGI_HTTP_UTF8_FILTER_HPP
+#define MOSH_CGI_HTTP_UTF8_FILTER_HPP
+
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+//! What to do with invalid UTF-8
+namespace Utf8_check {
+	//! Replace each invalid sequence with U+FFFD
+	const unsigned repair = 0;
+	//! Fail the stream at the first invalid sequence; what came before it is written
+	const unsigned reject = 1;
+}
+
+/*! @brief Get the charset parameter of a Content-Type
+ *  @param[in] content_type a Content-Type value or header line,
+ *    e.g. "text/html; charset=UTF-8"
+ *  @return the charset, without quotes, or an empty view if there is none
+ */
+String_view charset_of(String_view content_type);
+
+/*! @brief Check whether a charset name denotes UTF-8
+ *  @param[in] charset charset name, compared case-insensitively
+ */
+bool is_utf8_charset(String_view charset);
+
+/*! @brief Output filter which checks UTF-8
+ * Sits between a stream and its buffer, checking what passes through and
+ * repairing or rejecting invalid sequences (see Utf8_check). Output is buffered in
+ * blocks; a block which is valid, as is nearly always the case, is passed on as is
+ * after one scan. A sequence split across blocks is held back until it is complete.
+ *
+ * Invalid input makes overflow() fail in Utf8_check::reject mode, which sets
+ * badbit on the stream.
+ */
+class Utf8_filter : public std::streambuf {
+public:
+	/*! @brief Filter output to a buffer
+	 *  @param[in] dest buffer to write to
+	 *  @param[in] mode one of Utf8_check
+	 */
+	Utf8_filter(std::streambuf* dest, unsigned mode = Utf8_check::repair);
+
+	//! Calls finish()
+	~Utf8_filter();
+
+	/*! @brief Flush everything, including an incomplete sequence at the end
+	 *  An incomplete sequence is invalid once the output ends.
+	 *  @retval false if output failed or was rejected
+	 */
+	bool finish();
+
+	//! Whether invalid input was rejected
+	bool rejected() const {
+		return failed;
+	}
+
+protected:
+	int_type overflow(int_type c);
+	std::streamsize xsputn(const char* s, std::streamsize n);
+	int sync();
+
+private:
+	Utf8_filter(const Utf8_filter&) = delete;
+	Utf8_filter& operator = (const Utf8_filter&) = delete;
+
+	bool _drain(bool final);
+	bool _write(const char* s, size_t n);
+
+	std::streambuf* dest;
+	unsigned mode;
+	bool failed;
+	bool error;
+	//! Repaired output
+	std::string fixed;
+	char buf[8192];
+};
+
+/*! @brief Check a response body according to its declared charset
+ * If the charset is UTF-8, installs a Utf8_filter on a stream for the lifetime
+ * of this object, and does nothing otherwise:
+ * @code
+ * cout << content_type::print_ct_with_cs("text/html", cs);
+ * http::Utf8_output checked(cout, cs);
+ * cout << body;
+ * @endcode
+ */
+class Utf8_output {
+public:
+	/*! @brief Check output, if charset is UTF-8
+	 *  @param[in,out] os stream
+	 *  @param[in] charset declared charset, or a Content-Type (see charset_of())
+	 *  @param[in] mode one of Utf8_check
+	 */
+	Utf8_output(std::ostream& os, String_view charset, unsigned mode = Utf8_check::repair);
+
+	//! Flushes the filter and restores the stream's buffer
+	~Utf8_output();
+
+	//! Whether a filter is installed
+	bool active() const {
+		return filter != nullptr;
+	}
+
+	//! Whether invalid output was rejected
+	bool rejected() const {
+		return filter != nullptr && filter->rejected();
+	}
+
+private:
+	Utf8_output(const Utf8_output&) = delete;
+	Utf8_output& operator = (const Utf8_output&) = delete;
+
+	std::ostream& os;
+	std::unique_ptr<Utf8_filter> filter;
+	std::streambuf* saved;
+};
+
+}
+
+MOSH_CGI_END
+
+#endif
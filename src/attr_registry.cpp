@@ -0,0 +1,77 @@
+//! @file attr_registry.cpp Runtime lookup of HTML attribute keys by name
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <mosh/cgi/html/element/attr.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+namespace html {
+namespace element {
+namespace attr {
+
+namespace {
+
+constexpr Key keys[] = {
+#define MOSH_CGI_HTML_ATTR(ident_, name_, context_) ident_,
+#include <mosh/cgi/html/element/attrs.def>
+#undef MOSH_CGI_HTML_ATTR
+};
+
+static_assert(sizeof(keys) / sizeof(keys[0]) == n_keys, "attrs.def and attr::Id disagree");
+
+constexpr int compare(const char* a, const char* b) {
+	return (*a != *b || *a == '\0') ? static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b)
+		: compare(a + 1, b + 1);
+}
+
+constexpr bool sorted(size_t i = 1) {
+	return (i >= n_keys) || (compare(keys[i - 1].name, keys[i].name) < 0 && sorted(i + 1));
+}
+
+static_assert(sorted(), "attrs.def is not in strcmp order");
+
+}
+
+/*! @brief Find a key by name
+ *  @param[in] name attribute name
+ *  @param[in] n length of name
+ *  @return the key, or a null pointer if the name is unknown
+ */
+const Key* find(const char* name, size_t n) {
+	auto less = [] (const Key& k, std::pair<const char*, size_t> s) {
+		int c = std::memcmp(k.name, s.first, std::min(k.size, s.second));
+		return (c != 0) ? (c < 0) : (k.size < s.second);
+	};
+	const Key* k = std::lower_bound(keys, keys + n_keys, std::make_pair(name, n), less);
+	if (k != keys + n_keys && k->size == n && !std::memcmp(k->name, name, n))
+		return k;
+	return nullptr;
+}
+
+const Key& key(unsigned id) {
+	return keys[id];
+}
+
+}
+}
+}
+MOSH_CGI_END
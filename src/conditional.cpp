@@ -0,0 +1,163 @@
+//! @file conditional.cpp Validators and responses rendered on demand
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstring>
+#include <ctime>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <mosh/cgi/http/conditional.hpp>
+#include <mosh/cgi/http/etag.hpp>
+#include <mosh/cgi/http/field_map.hpp>
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/http/response.hpp>
+#include <mosh/cgi/http/misc.hpp>
+#include <mosh/cgi/http/helpers/status.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+namespace {
+
+//! Whether a field value is "*", give or take white space
+bool is_star(const std::string& v) {
+	const size_t b = v.find_first_not_of(" \t");
+	return b != std::string::npos && v[b] == '*' && v.find_first_not_of(" \t", b + 1) == std::string::npos;
+}
+
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+Request_conditions request_conditions(const char* const* envp) {
+	static const struct {
+		const char* name;
+		size_t size;
+		std::string Request_conditions::* field;
+	} vars[] = {
+		{ "REQUEST_METHOD=", 15, &Request_conditions::method },
+		{ "HTTP_IF_NONE_MATCH=", 19, &Request_conditions::if_none_match },
+		{ "HTTP_IF_MODIFIED_SINCE=", 23, &Request_conditions::if_modified_since },
+		{ "HTTP_RANGE=", 11, &Request_conditions::range },
+		{ "HTTP_IF_RANGE=", 14, &Request_conditions::if_range },
+	};
+	Request_conditions c;
+	for (; envp != nullptr && *envp != nullptr; ++envp) {
+		for (const auto& v : vars) {
+			if (!std::strncmp(*envp, v.name, v.size)) {
+				c.*v.field = *envp + v.size;
+				break;
+			}
+		}
+	}
+	return c;
+}
+
+Validators& Validators::version(String_view token) {
+	for (char c : token) {
+		if (c <= ' ' || c == '"' || c == 0x7f)
+			throw std::invalid_argument("MOSH_CGI::http::Validators: bad character in version");
+	}
+	_etag.reserve(token.size() + 2);
+	_etag = '"';
+	_etag += token;
+	_etag += '"';
+	return *this;
+}
+
+unsigned Validators::evaluate(const Request_conditions& c) const {
+	if (!c.if_none_match.empty()) {
+		// "*" matches any current representation, tagged or not
+		const bool match = _etag.empty() ? is_star(c.if_none_match)
+			: etag_matches(c.if_none_match, _etag);
+		if (!match)
+			return 0;
+		return c.safe() ? 304 : 412;
+	}
+	if (has_last_modified && c.safe() && !c.if_modified_since.empty()) {
+		time_t since;
+		if (parse_http_date(c.if_modified_since, since) && since <= std::time(nullptr)
+				&& _last_modified <= since)
+			return 304;
+	}
+	return 0;
+}
+
+String_view Validators::range(const Request_conditions& c) const {
+	// Range only applies to GET
+	if (c.range.empty() || c.method != "GET")
+		return String_view();
+	const size_t b = c.if_range.find_first_not_of(" \t");
+	if (b == std::string::npos)
+		return c.range;
+	const size_t e = c.if_range.find_last_not_of(" \t") + 1;
+	const String_view v(c.if_range.data() + b, e - b);
+	bool current;
+	if (v[0] == '"') {
+		// An entity tag, compared strongly: a weak one never matches
+		current = !_etag.empty() && _etag[0] == '"' && v == String_view(_etag);
+	} else if (v[0] == 'W' && v.size() > 1 && v[1] == '/') {
+		current = false;
+	} else {
+		time_t t;
+		current = has_last_modified && parse_http_date(v, t) && t == _last_modified;
+	}
+	return current ? String_view(c.range) : String_view();
+}
+
+void Validators::add_to(header::Header& h) const {
+	if (!_etag.empty() && !h.has(field::etag))
+		h.append(field::etag.name, _etag);
+	if (has_last_modified && !h.has(field::last_modified)) {
+		char date[http_date_size];
+		format_http_date(date, _last_modified);
+		h.append(field::last_modified.name, String_view(date, sizeof(date)));
+	}
+}
+
+bool send_deferred(std::ostream& os, header::Header& h, const Validators& v,
+		const Request_conditions& c, const Body_producer& body)
+{
+	v.add_to(h);
+	const std::string* status = h.find(field::status);
+	const unsigned cut = (status == nullptr || (*status)[0] == '2') ? v.evaluate(c) : 0;
+	Response* r = dynamic_cast<Response*>(&os);
+	if (r != nullptr) {
+		// The Response sends the header, and no body for a 304
+		if (&h != &r->header)
+			r->header += h;
+		if (cut != 0)
+			r->header.set(field::status.name, std::to_string(cut) + ' '
+				+ helpers::status_helper::get_string(cut));
+	} else {
+		std::string head = h;
+		if (cut != 0)
+			helpers::status::set_status(head, cut);
+		os.write(head.data(), head.size());
+	}
+	if (cut != 0 || c.head())
+		return false;
+	body(os);
+	return true;
+}
+
+}
+
+MOSH_CGI_END
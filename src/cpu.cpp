@@ -0,0 +1,77 @@
+//! @file cpu.cpp Runtime CPU feature dispatch
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <mosh/cgi/bits/cpu.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+namespace {
+
+const char* const names[] = { "generic", "sse2", "avx2" };
+
+unsigned probe() {
+#ifdef MOSH_CGI_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return MOSH_CGI::cpu::avx2;
+	if (__builtin_cpu_supports("sse2"))
+		return MOSH_CGI::cpu::sse2;
+#endif
+	return MOSH_CGI::cpu::generic;
+}
+
+unsigned choose() {
+	const unsigned d = MOSH_CGI::cpu::detected();
+	const char* env = std::getenv("MOSH_CGI_CPU");
+	if (env == nullptr)
+		return d;
+	const unsigned l = MOSH_CGI::cpu::parse(env);
+	return (l <= d) ? l : d;
+}
+
+}
+
+MOSH_CGI_BEGIN
+namespace cpu {
+
+unsigned detected() {
+	static const unsigned d = probe();
+	return d;
+}
+
+unsigned level() {
+	static const unsigned l = choose();
+	return l;
+}
+
+const char* name(unsigned l) {
+	return (l < n_levels) ? names[l] : "unknown";
+}
+
+unsigned parse(const char* s) {
+	for (unsigned l = 0; l < n_levels; ++l) {
+		if (!std::strcmp(s, names[l]))
+			return l;
+	}
+	return n_levels;
+}
+
+}
+MOSH_CGI_END
@@ -0,0 +1,108 @@
+//! @file data_uri.cpp data: URI attributes
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <mosh/cgi/html/element/attr.hpp>
+#include <mosh/cgi/http/misc.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+namespace {
+
+using namespace MOSH_CGI;
+
+// Input block; a multiple of 3, so that blocks encode without padding
+const size_t block_size = 3 * 4096;
+
+//! Start a value: set its prefix and reserve room for n input bytes
+template <typename charT>
+void begin(std::basic_string<charT>& value, String_view mime, size_t n) {
+	static const char head[] = "data:";
+	static const char tail[] = ";base64,";
+	value.reserve(sizeof(head) - 1 + mime.size() + sizeof(tail) - 1 + http::base64_encoded_size(n));
+	value.append(head, head + sizeof(head) - 1);
+	value.append(mime.begin(), mime.end());
+	value.append(tail, tail + sizeof(tail) - 1);
+}
+
+//! Encode into the end of a narrow value, in place
+void append(std::string& value, String_view data) {
+	http::base64_encode(value, data);
+}
+
+//! Encode into the end of a wide value, through a block on the stack
+void append(std::wstring& value, String_view data) {
+	char buf[http::base64_encoded_size(block_size)];
+	for (size_t i = 0; i < data.size(); i += block_size) {
+		const size_t n = (data.size() - i < block_size) ? data.size() - i : block_size;
+		const size_t m = http::base64_encode(buf, String_view(data.data() + i, n));
+		value.append(buf, buf + m);
+	}
+}
+
+}
+
+MOSH_CGI_BEGIN
+namespace html {
+namespace element {
+namespace attr {
+
+template <typename charT>
+Key_value<charT> data_uri(const Key& k, String_view mime, String_view data) {
+	Key_value<charT> kv { &k, std::basic_string<charT>(), Basic_string_view<charT>() };
+	begin(kv.value, mime, data.size());
+	append(kv.value, data);
+	return kv;
+}
+
+template <typename charT>
+Key_value<charT> data_uri_file(const Key& k, String_view mime, const std::string& path) {
+	std::ifstream f(path.c_str(), std::ios::in | std::ios::binary);
+	if (!f)
+		throw std::invalid_argument("MOSH_CGI::html::element::attr::data_uri_file: cannot open file");
+	f.seekg(0, std::ios::end);
+	const std::streamoff size = f.tellg();
+	f.seekg(0, std::ios::beg);
+	Key_value<charT> kv { &k, std::basic_string<charT>(), Basic_string_view<charT>() };
+	begin(kv.value, mime, (size > 0) ? static_cast<size_t>(size) : 0);
+	char buf[block_size];
+	/* Every block but the last is a multiple of 3 bytes long, so the blocks can be
+	 * encoded one by one and the result is the encoding of the whole file.
+	 */
+	while (f) {
+		f.read(buf, block_size);
+		if (f.bad())
+			throw std::invalid_argument("MOSH_CGI::html::element::attr::data_uri_file: cannot read file");
+		append(kv.value, String_view(buf, f.gcount()));
+	}
+	return kv;
+}
+
+template Key_value<char> data_uri<char>(const Key&, String_view, String_view);
+template Key_value<wchar_t> data_uri<wchar_t>(const Key&, String_view, String_view);
+template Key_value<char> data_uri_file<char>(const Key&, String_view, const std::string&);
+template Key_value<wchar_t> data_uri_file<wchar_t>(const Key&, String_view, const std::string&);
+
+}
+}
+}
+MOSH_CGI_END
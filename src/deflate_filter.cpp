@@ -0,0 +1,410 @@
+//! @file deflate_filter.cpp Compressing output stage
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+
+extern "C" {
+#include <zlib.h>
+}
+
+#include <mosh/cgi/http/deflate_filter.hpp>
+#include <mosh/cgi/http/field_map.hpp>
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/http/response.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+namespace {
+
+using MOSH_CGI::String_view;
+
+inline bool is_lws(char c) {
+	return c == ' ' || c == '\t';
+}
+
+String_view trim(const char* b, const char* e) {
+	while (b < e && is_lws(*b))
+		++b;
+	while (e > b && is_lws(e[-1]))
+		--e;
+	return String_view(b, e - b);
+}
+
+inline bool name_is(String_view s, const char* name) {
+	const size_t n = std::strlen(name);
+	return MOSH_CGI::http::field_equal(s.data(), s.size(), name, n);
+}
+
+/* q-values have at most three decimals (RFC 7231, 5.3.1), so they are parsed into
+ * thousandths; a malformed one counts as 1.
+ */
+unsigned parse_q(String_view s) {
+	size_t i = 0;
+	if (i == s.size() || (s[i] != '0' && s[i] != '1'))
+		return 1000;
+	unsigned q = (s[i++] - '0') * 1000;
+	if (i < s.size() && s[i] == '.') {
+		unsigned scale = 100;
+		for (++i; i < s.size() && scale != 0 && s[i] >= '0' && s[i] <= '9'; ++i, scale /= 10)
+			q += (s[i] - '0') * scale;
+	}
+	return (q > 1000) ? 1000 : q;
+}
+
+void put_be32(unsigned char* p, uLong v) {
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+void put_le32(unsigned char* p, uLong v) {
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+const char* coding_name(unsigned coding) {
+	switch (coding) {
+	case Coding::deflate:
+		return "deflate";
+	case Coding::gzip:
+		return "gzip";
+	default:;
+	}
+	return nullptr;
+}
+
+unsigned negotiate_coding(String_view ae) {
+	// q-values in thousandths; -1 means not listed
+	int gzip = -1;
+	int deflate = -1;
+	int any = -1;
+	const char* p = ae.data();
+	const char* const end = p + ae.size();
+	// Each element is "coding *( ; param )", e.g. "gzip;q=0.8"
+	while (p < end) {
+		const void* comma = std::memchr(p, ',', end - p);
+		const char* e = (comma == nullptr) ? end : static_cast<const char*>(comma);
+		const void* semi = std::memchr(p, ';', e - p);
+		const char* ne = (semi == nullptr) ? e : static_cast<const char*>(semi);
+		const String_view name = trim(p, ne);
+		int q = 1000;
+		for (const char* a = ne; a < e; ) {
+			const void* next = std::memchr(a + 1, ';', e - a - 1);
+			const char* pe = (next == nullptr) ? e : static_cast<const char*>(next);
+			const String_view param = trim(a + 1, pe);
+			if (param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=')
+				q = parse_q(trim(param.data() + 2, param.data() + param.size()));
+			a = pe;
+		}
+		if (name_is(name, "gzip") || name_is(name, "x-gzip"))
+			gzip = q;
+		else if (name_is(name, "deflate"))
+			deflate = q;
+		else if (name_is(name, "*"))
+			any = q;
+		p = (comma == nullptr) ? end : e + 1;
+	}
+	if (gzip < 0)
+		gzip = any;
+	if (deflate < 0)
+		deflate = any;
+	if (gzip <= 0 && deflate <= 0)
+		return Coding::identity;
+	return (gzip >= deflate) ? Coding::gzip : Coding::deflate;
+}
+
+/* The compressor runs in raw deflate mode, and the zlib or gzip wrapper is written
+ * here. That way a precompressed fragment can be spliced in between two deflate
+ * blocks, with its check value combined into the running one.
+ */
+struct Deflate_filter::State {
+	z_stream s;
+	unsigned coding;
+	//! Running CRC-32 (gzip) or Adler-32 (zlib) of the input
+	uLong check;
+	//! Input bytes, including spliced fragments
+	size_t in;
+	//! Bytes written to dest
+	size_t out;
+	//! Whether input went into the compressor since the last full flush
+	bool pending;
+};
+
+Deflate_filter::Deflate_filter(std::streambuf* dest_, unsigned coding, int level, String_view dict)
+: z(new State), dest(dest_), done(false), error(false)
+{
+	if (coding != Coding::deflate && coding != Coding::gzip)
+		throw std::invalid_argument("MOSH_CGI::http::Deflate_filter: unsupported coding");
+	if (level < Deflate_level::standard || level > Deflate_level::best)
+		throw std::invalid_argument("MOSH_CGI::http::Deflate_filter: invalid level");
+	if (coding == Coding::gzip && !dict.empty())
+		throw std::invalid_argument("MOSH_CGI::http::Deflate_filter: gzip cannot carry a dictionary");
+	std::memset(&z->s, 0, sizeof(z->s));
+	z->coding = coding;
+	z->check = (coding == Coding::gzip) ? crc32(0, Z_NULL, 0) : adler32(0, Z_NULL, 0);
+	z->in = 0;
+	z->out = 0;
+	z->pending = false;
+	if (deflateInit2(&z->s, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		throw std::bad_alloc();
+	if (!dict.empty() && deflateSetDictionary(&z->s, reinterpret_cast<const Bytef*>(dict.data()),
+			dict.size()) != Z_OK) {
+		deflateEnd(&z->s);
+		throw std::invalid_argument("MOSH_CGI::http::Deflate_filter: bad dictionary");
+	}
+	unsigned char head[10];
+	size_t n;
+	if (coding == Coding::gzip) {
+		// No name, no time stamp, OS unknown
+		const unsigned char gz[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+		std::memcpy(head, gz, sizeof(gz));
+		n = sizeof(gz);
+	} else {
+		// 32K window; the level hint is as zlib itself would write it
+		const unsigned hint = (level == Deflate_level::standard || level == 6) ? 2
+			: (level < 2) ? 0 : (level < 6) ? 1 : 3;
+		unsigned h = (0x78 << 8) | (hint << 6) | (dict.empty() ? 0 : 0x20);
+		h += 31 - h % 31;
+		head[0] = h >> 8;
+		head[1] = h & 0xff;
+		n = 2;
+		if (!dict.empty()) {
+			put_be32(head + 2, adler32(adler32(0, Z_NULL, 0),
+				reinterpret_cast<const Bytef*>(dict.data()), dict.size()));
+			n = 6;
+		}
+	}
+	_write(reinterpret_cast<const char*>(head), n);
+	setp(buf, buf + sizeof(buf));
+}
+
+Deflate_filter::~Deflate_filter() {
+	finish();
+	deflateEnd(&z->s);
+}
+
+bool Deflate_filter::finish() {
+	if (done)
+		return !error;
+	bool ok = _deflate(Z_FINISH);
+	done = true;
+	if (ok) {
+		unsigned char tail[8];
+		if (z->coding == Coding::gzip) {
+			put_le32(tail, z->check);
+			put_le32(tail + 4, z->in);
+			ok = _write(reinterpret_cast<const char*>(tail), 8);
+		} else {
+			put_be32(tail, z->check);
+			ok = _write(reinterpret_cast<const char*>(tail), 4);
+		}
+	}
+	return ok && dest->pubsync() == 0;
+}
+
+bool Deflate_filter::splice(const Deflated_fragment& f) {
+	if ((pptr() != pbase() || z->pending) && !_deflate(Z_FULL_FLUSH))
+		return false;
+	if (done || error || !_write(f.deflated().data(), f.deflated().size()))
+		return false;
+	z->check = (z->coding == Coding::gzip)
+		? crc32_combine(z->check, f.crc32(), f.size())
+		: adler32_combine(z->check, f.adler32(), f.size());
+	z->in += f.size();
+	return true;
+}
+
+size_t Deflate_filter::bytes_in() const {
+	return z->in + (pptr() - pbase());
+}
+
+size_t Deflate_filter::bytes_out() const {
+	return z->out;
+}
+
+Deflate_filter::int_type Deflate_filter::overflow(int_type c) {
+	if (!_deflate(Z_NO_FLUSH))
+		return traits_type::eof();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+std::streamsize Deflate_filter::xsputn(const char* s, std::streamsize n) {
+	std::streamsize written = 0;
+	while (written < n) {
+		std::streamsize room = epptr() - pptr();
+		if (room == 0) {
+			if (!_deflate(Z_NO_FLUSH))
+				break;
+			continue;
+		}
+		const std::streamsize k = (n - written < room) ? n - written : room;
+		std::memcpy(pptr(), s + written, k);
+		pbump(static_cast<int>(k));
+		written += k;
+	}
+	return written;
+}
+
+int Deflate_filter::sync() {
+	return (_deflate(Z_SYNC_FLUSH) && dest->pubsync() == 0) ? 0 : -1;
+}
+
+bool Deflate_filter::_write(const char* s, size_t n) {
+	if (n != 0 && dest->sputn(s, n) != static_cast<std::streamsize>(n))
+		error = true;
+	z->out += n;
+	return !error;
+}
+
+/* Compress the buffer and write out whatever zlib produces. With Z_NO_FLUSH zlib
+ * keeps what it cannot emit yet in its own window, so the whole buffer is always
+ * consumed and can be reused.
+ */
+bool Deflate_filter::_deflate(int flush) {
+	if (done || error)
+		return false;
+	z_stream& s = z->s;
+	const size_t n_in = pptr() - pbase();
+	s.next_in = reinterpret_cast<Bytef*>(pbase());
+	s.avail_in = n_in;
+	if (n_in == 0 && flush == Z_NO_FLUSH)
+		return true;
+	if (n_in != 0) {
+		z->check = (z->coding == Coding::gzip) ? crc32(z->check, s.next_in, n_in)
+			: adler32(z->check, s.next_in, n_in);
+		z->in += n_in;
+		z->pending = true;
+	}
+	int rc;
+	do {
+		s.next_out = reinterpret_cast<Bytef*>(out);
+		s.avail_out = sizeof(out);
+		rc = deflate(&s, flush);
+		if (rc == Z_STREAM_ERROR) {
+			error = true;
+			return false;
+		}
+		if (!_write(out, sizeof(out) - s.avail_out))
+			return false;
+	} while (s.avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+	if (flush == Z_FULL_FLUSH || flush == Z_FINISH)
+		z->pending = false;
+	setp(buf, buf + sizeof(buf));
+	return true;
+}
+
+Deflated_fragment::Deflated_fragment(String_view raw, int level)
+: _raw(raw.str()), _deflated(), _crc32(0), _adler32(0)
+{
+	if (level < Deflate_level::standard || level > Deflate_level::best)
+		throw std::invalid_argument("MOSH_CGI::http::Deflated_fragment: invalid level");
+	const Bytef* const p = reinterpret_cast<const Bytef*>(_raw.data());
+	_crc32 = ::crc32(::crc32(0, Z_NULL, 0), p, _raw.size());
+	_adler32 = ::adler32(::adler32(0, Z_NULL, 0), p, _raw.size());
+	z_stream s;
+	std::memset(&s, 0, sizeof(s));
+	if (deflateInit2(&s, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		throw std::bad_alloc();
+	// A full flush ends on a byte boundary, with nothing referring to what precedes
+	_deflated.resize(deflateBound(&s, _raw.size()) + 16);
+	s.next_in = const_cast<Bytef*>(p);
+	s.avail_in = _raw.size();
+	s.next_out = reinterpret_cast<Bytef*>(&_deflated[0]);
+	s.avail_out = _deflated.size();
+	const int rc = deflate(&s, Z_FULL_FLUSH);
+	const bool complete = s.avail_in == 0 && (rc == Z_OK || rc == Z_BUF_ERROR);
+	_deflated.resize(_deflated.size() - s.avail_out);
+	deflateEnd(&s);
+	// A fragment cut short would corrupt every stream it is spliced into
+	if (!complete)
+		throw std::runtime_error("MOSH_CGI::http::Deflated_fragment: deflate failed");
+}
+
+std::ostream& operator << (std::ostream& os, const Deflated_fragment& f) {
+	Deflate_filter* z = dynamic_cast<Deflate_filter*>(os.rdbuf());
+	if (z == nullptr)
+		return os.write(f.raw().data(), f.raw().size());
+	if (!z->splice(f))
+		os.setstate(std::ios_base::badbit);
+	return os;
+}
+
+Compressed_output::Compressed_output(std::ostream& os_, header::Header& h, String_view ae,
+		int level, String_view dict)
+: os(os_), _coding(Coding::identity), _filter(), saved(nullptr)
+{
+	Response* r = dynamic_cast<Response*>(&os);
+	// Once a Response has sent its header, the coding cannot be declared
+	if (r != nullptr && r->committed())
+		return;
+	if (!h.has(field::content_encoding)) {
+		_coding = negotiate_coding(ae);
+		if (_coding != Coding::identity)
+			h.append(field::content_encoding.name, coding_name(_coding));
+		h.append(field::vary.name, "Accept-Encoding");
+	}
+	if (r != nullptr) {
+		// The Response sends the header, with the length of what reaches its buffer
+		if (&h != &r->header)
+			r->header += h;
+		if (_coding != Coding::identity)
+			r->header.erase(field::content_length.name);
+	} else {
+		const std::string head = h;
+		os.write(head.data(), head.size());
+		if (_coding != Coding::identity)
+			os.flush();
+	}
+	if (_coding != Coding::identity) {
+		_filter.reset(new Deflate_filter(os.rdbuf(), _coding, level,
+			(_coding == Coding::deflate) ? dict : String_view()));
+		saved = os.rdbuf(_filter.get());
+	}
+}
+
+Compressed_output::~Compressed_output() {
+	// No flush first: it would cost an extra (empty) compressed block
+	if (_filter != nullptr) {
+		_filter->finish();
+		os.rdbuf(saved);
+	}
+}
+
+}
+
+MOSH_CGI_END
@@ -0,0 +1,192 @@
+//! @file etag.cpp Entity tags and conditional responses
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <mosh/cgi/http/etag.hpp>
+#include <mosh/cgi/http/field_map.hpp>
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/http/response.hpp>
+#include <mosh/cgi/http/helpers/status.hpp>
+#include <mosh/cgi/bits/xxh64.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+namespace {
+
+using MOSH_CGI::String_view;
+
+inline bool is_lws(char c) {
+	return c == ' ' || c == '\t';
+}
+
+//! Strip white space and a weakness indicator
+String_view opaque_tag(const char* b, const char* e) {
+	while (b < e && is_lws(*b))
+		++b;
+	while (e > b && is_lws(e[-1]))
+		--e;
+	if (e - b >= 2 && b[0] == 'W' && b[1] == '/')
+		b += 2;
+	return String_view(b, e - b);
+}
+
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+std::string make_etag(uint64_t h) {
+	static const char hex[] = "0123456789abcdef";
+	std::string t(18, '"');
+	for (unsigned i = 0; i < 16; ++i)
+		t[16 - i] = hex[(h >> (4 * i)) & 0xf];
+	return t;
+}
+
+bool etag_matches(String_view inm, String_view etag) {
+	const String_view tag = opaque_tag(etag.begin(), etag.end());
+	const char* p = inm.begin();
+	const char* const end = inm.end();
+	while (p < end) {
+		// Commas cannot appear in an entity tag, so the list splits on them
+		const void* comma = std::memchr(p, ',', end - p);
+		const char* e = (comma == nullptr) ? end : static_cast<const char*>(comma);
+		const String_view t = opaque_tag(p, e);
+		if (t == tag || t == String_view("*", 1))
+			return true;
+		p = e + 1;
+	}
+	return false;
+}
+
+Etag_buffer::Etag_buffer()
+: hash(), _body()
+{
+	setp(buf, buf + sizeof(buf));
+}
+
+const std::string& Etag_buffer::body() {
+	_drain();
+	return _body;
+}
+
+std::string Etag_buffer::etag() {
+	_drain();
+	return make_etag(hash.digest());
+}
+
+Etag_buffer::int_type Etag_buffer::overflow(int_type c) {
+	_drain();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+std::streamsize Etag_buffer::xsputn(const char* s, std::streamsize n) {
+	// Large writes bypass the buffer
+	if (n >= static_cast<std::streamsize>(sizeof(buf))) {
+		_drain();
+		hash.update(s, n);
+		_body.append(s, n);
+		return n;
+	}
+	std::streamsize written = 0;
+	while (written < n) {
+		std::streamsize room = epptr() - pptr();
+		if (room == 0) {
+			_drain();
+			continue;
+		}
+		const std::streamsize k = (n - written < room) ? n - written : room;
+		std::memcpy(pptr(), s + written, k);
+		pbump(static_cast<int>(k));
+		written += k;
+	}
+	return written;
+}
+
+int Etag_buffer::sync() {
+	return 0;
+}
+
+void Etag_buffer::_drain() {
+	const size_t n = pptr() - pbase();
+	hash.update(pbase(), n);
+	_body.append(pbase(), n);
+	setp(buf, buf + sizeof(buf));
+}
+
+Etag_output::Etag_output(std::ostream& os_, header::Header& h_, String_view inm)
+: os(os_), h(h_), if_none_match(inm.str()), buffer(), saved(nullptr), _not_modified(false)
+{
+	saved = os.rdbuf(&buffer);
+}
+
+Etag_output::~Etag_output() {
+	finish();
+}
+
+void Etag_output::finish() {
+	if (saved == nullptr)
+		return;
+	os.rdbuf(saved);
+	saved = nullptr;
+	Response* r = dynamic_cast<Response*>(&os);
+	const std::string* status = h.find(field::status);
+	if ((r == nullptr || !r->committed()) && (status == nullptr || status->compare(0, 3, "200") == 0)) {
+		const std::string* tag = h.find(field::etag);
+		if (tag == nullptr) {
+			h.append(field::etag.name, buffer.etag());
+			tag = h.find(field::etag);
+		}
+		_not_modified = etag_matches(if_none_match, *tag);
+	}
+	const std::string& body = buffer.body();
+	if (r != nullptr) {
+		// The Response sends the header; as a 304, it drops the body
+		if (&h != &r->header)
+			r->header += h;
+		if (_not_modified)
+			r->header.set(field::status.name, "304 " + helpers::status_helper::get_string(304));
+		else
+			os.write(body.data(), body.size());
+		return;
+	}
+	std::string head = h;
+	if (_not_modified) {
+		helpers::status::set_status(head, 304);
+		os.write(head.data(), head.size());
+	} else {
+		os.write(head.data(), head.size());
+		os.write(body.data(), body.size());
+	}
+	os.flush();
+}
+
+}
+
+MOSH_CGI_END
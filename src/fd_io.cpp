@@ -0,0 +1,195 @@
+//! @file fd_io.cpp File descriptor output
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <streambuf>
+#include <string>
+#include <mosh/cgi/bits/fd_io.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+extern "C" {
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+}
+
+namespace {
+
+//! Mapping window for copying out of a file; a multiple of any page size
+const size_t window = 8 << 20;
+
+//! Handle a failed write; returns whether to try again
+bool again(int fd) {
+	if (errno == EINTR)
+		return true;
+	if (errno == EAGAIN || errno == EWOULDBLOCK) {
+		pollfd pf = { fd, POLLOUT, 0 };
+		return ::poll(&pf, 1, -1) >= 0 || errno == EINTR;
+	}
+	return false;
+}
+
+//! Map part of a file; returns the start of the mapping and, in at, where the data starts
+void* map(int in, off_t offset, size_t n, const char*& at, size_t& len) {
+	static const off_t page = ::sysconf(_SC_PAGESIZE);
+	const off_t base = offset - offset % page;
+	len = n + (offset - base);
+	void* m = ::mmap(nullptr, len, PROT_READ, MAP_SHARED, in, base);
+	if (m == MAP_FAILED)
+		return nullptr;
+	::madvise(m, len, MADV_SEQUENTIAL);
+	at = static_cast<const char*>(m) + (offset - base);
+	return m;
+}
+
+}
+
+MOSH_CGI_BEGIN
+
+namespace fd_io {
+
+bool write_all(int fd, iovec* p, int n) {
+	for (;;) {
+		while (n != 0 && p->iov_len == 0) {
+			++p;
+			--n;
+		}
+		if (n == 0)
+			return true;
+		ssize_t w = ::writev(fd, p, n);
+		if (w < 0) {
+			if (again(fd))
+				continue;
+			return false;
+		}
+		for (; n != 0 && static_cast<size_t>(w) >= p->iov_len; ++p, --n)
+			w -= p->iov_len;
+		if (n != 0) {
+			p->iov_base = static_cast<char*>(p->iov_base) + w;
+			p->iov_len -= w;
+		}
+	}
+}
+
+bool write_all(int fd, const void* p, size_t n) {
+	iovec v = { const_cast<void*>(p), n };
+	return write_all(fd, &v, 1);
+}
+
+bool send_file(int out, int in, off_t offset, size_t n) {
+#ifdef __linux__
+	struct stat st;
+	if (n != 0 && ::fstat(out, &st) == 0 && S_ISFIFO(st.st_mode)) {
+		while (n != 0) {
+			const ssize_t w = ::splice(in, &offset, out, nullptr, (n < window) ? n : window,
+				SPLICE_F_MORE);
+			if (w > 0) {
+				n -= w;
+			} else if (w == 0) {
+				errno = EIO;
+				return false;
+			} else if (errno == EINVAL || errno == ENOSYS) {
+				break;
+			} else if (!again(out)) {
+				return false;
+			}
+		}
+	}
+	while (n != 0) {
+		const ssize_t w = ::sendfile(out, in, &offset, (n < window) ? n : window);
+		if (w > 0) {
+			n -= w;
+		} else if (w == 0) {
+			// The file is shorter than it was said to be
+			errno = EIO;
+			return false;
+		} else if (errno == EINVAL || errno == ENOSYS) {
+			// Not supported for this pair of descriptors
+			break;
+		} else if (!again(out)) {
+			return false;
+		}
+	}
+#endif
+	while (n != 0) {
+		const size_t k = (n < window) ? n : window;
+		const char* at;
+		size_t len;
+		void* m = map(in, offset, k, at, len);
+		if (m == nullptr)
+			return false;
+		const bool ok = write_all(out, at, k);
+		::munmap(m, len);
+		if (!ok)
+			return false;
+		offset += k;
+		n -= k;
+	}
+	return true;
+}
+
+bool send_file(std::streambuf* out, int in, off_t offset, size_t n) {
+	while (n != 0) {
+		const size_t k = (n < window) ? n : window;
+		const char* at;
+		size_t len;
+		void* m = map(in, offset, k, at, len);
+		if (m == nullptr)
+			return false;
+		const bool ok = out->sputn(at, k) == static_cast<std::streamsize>(k);
+		::munmap(m, len);
+		if (!ok)
+			return false;
+		offset += k;
+		n -= k;
+	}
+	return true;
+}
+
+int temp_file() {
+	const char* dir = std::getenv("TMPDIR");
+	if (dir == nullptr || *dir == '\0')
+		dir = "/tmp";
+#ifdef O_TMPFILE
+	const int fd = ::open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+	if (fd >= 0)
+		return fd;
+#endif
+	std::string name(dir);
+	name += "/mosh_cgi.XXXXXX";
+	const int t = ::mkstemp(&name[0]);
+	if (t >= 0) {
+		::unlink(name.c_str());
+		::fcntl(t, F_SETFD, FD_CLOEXEC);
+	}
+	return t;
+}
+
+}
+
+MOSH_CGI_END
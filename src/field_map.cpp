@@ -0,0 +1,120 @@
+//! @file field_map.cpp Header field parsing
+/*
+ * Copyright (C) 2011 m0shbear
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstring>
+#include <string>
+#include <mosh/cgi/http/field_map.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+namespace {
+
+bool is_lws(char c) {
+	return c == ' ' || c == '\t';
+}
+
+void add_field(MOSH_CGI::http::Field_map<std::string>& fields, const char* name, size_t n,
+		const char* value, size_t vn)
+{
+	std::string& v = fields.get(name, n, MOSH_CGI::http::field_hash(name, n));
+	if (!v.empty())
+		v += ", ";
+	v.append(value, vn);
+}
+
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+/*! @brief Parse a block of "Name: value" lines
+ *  Lines without a colon (e.g. an HTTP status line) are skipped; repeated fields
+ *  are joined with ", ". Parsing stops after the first empty line.
+ *  @param[in] b header block
+ *  @param[in] n length of @c b
+ *  @param[in,out] fields map to add fields to
+ *  @return number of bytes consumed
+ */
+size_t parse_fields(const char* b, size_t n, Field_map<std::string>& fields) {
+	size_t pos = 0;
+	while (pos < n) {
+		const void* lf = std::memchr(b + pos, '\n', n - pos);
+		size_t eol = (lf == nullptr) ? n : static_cast<const char*>(lf) - b;
+		size_t next = (lf == nullptr) ? n : eol + 1;
+		size_t end = eol;
+		if (end > pos && b[end - 1] == '\r')
+			--end;
+		if (end == pos)
+			return next;
+		const void* colon = std::memchr(b + pos, ':', end - pos);
+		if (colon != nullptr) {
+			size_t c = static_cast<const char*>(colon) - b;
+			size_t v = c + 1;
+			while (v < end && is_lws(b[v]))
+				++v;
+			size_t ve = end;
+			while (ve > v && is_lws(b[ve - 1]))
+				--ve;
+			add_field(fields, b + pos, c - pos, b + v, ve - v);
+		}
+		pos = next;
+	}
+	return pos;
+}
+
+/*! @brief Collect the request header fields passed through a CGI environment
+ *  Each HTTP_FOO_BAR variable becomes a Foo-Bar field; CONTENT_TYPE and
+ *  CONTENT_LENGTH are included as well.
+ *  @param[in] envp NULL-terminated environment block, as in @c environ
+ */
+Field_map<std::string> request_fields(const char* const* envp) {
+	Field_map<std::string> fields;
+	std::string name;
+	for (; envp != nullptr && *envp != nullptr; ++envp) {
+		const char* e = *envp;
+		const char* eq = std::strchr(e, '=');
+		if (eq == nullptr)
+			continue;
+		const char* k;
+		if (!std::strncmp(e, "HTTP_", 5))
+			k = e + 5;
+		else if (!std::strncmp(e, "CONTENT_TYPE=", 13) || !std::strncmp(e, "CONTENT_LENGTH=", 15))
+			k = e;
+		else
+			continue;
+		name.assign(k, eq);
+		bool upper = true;
+		for (auto& c : name) {
+			if (c == '_') {
+				c = '-';
+				upper = true;
+			} else {
+				if (!upper && c >= 'A' && c <= 'Z')
+					c = c - 'A' + 'a';
+				upper = false;
+			}
+		}
+		add_field(fields, name.data(), name.size(), eq + 1, std::strlen(eq + 1));
+	}
+	return fields;
+}
+
+}
+
+MOSH_CGI_END
@@ -0,0 +1,56 @@
+//! @file file_body.cpp Response bodies sent from files
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <ios>
+#include <ostream>
+#include <stdexcept>
+#include <mosh/cgi/http/file_body.hpp>
+#include <mosh/cgi/http/response.hpp>
+#include <mosh/cgi/bits/fd_io.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+extern "C" {
+#include <sys/stat.h>
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+File_body::File_body(int fd_)
+: fd(fd_), offset(0), size(0)
+{
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+		throw std::invalid_argument("MOSH_CGI::http::File_body: not a regular file");
+	size = st.st_size;
+}
+
+std::ostream& operator << (std::ostream& os, const File_body& f) {
+	Response* r = dynamic_cast<Response*>(&os);
+	const bool ok = (r != nullptr) ? r->append(f)
+		: (os.rdbuf() != nullptr && fd_io::send_file(os.rdbuf(), f.fd, f.offset, f.size));
+	if (!ok)
+		os.setstate(std::ios_base::badbit);
+	return os;
+}
+
+}
+
+MOSH_CGI_END
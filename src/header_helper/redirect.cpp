@@ -23,6 +23,7 @@
 #include <mosh/cgi/http/helpers/helper.hpp>
 #include <mosh/cgi/http/helpers/redirect.hpp>
 #include <mosh/cgi/http/helpers/status.hpp>
+#include <mosh/cgi/http/misc.hpp>
 #include <mosh/cgi/bits/namespace.hpp>
 
 MOSH_CGI_BEGIN
@@ -36,7 +37,7 @@ namespace redirect {
 	
 /*! @brief Generate a redirection header
  *  @param[in] code HTTP status code (must be 3xx)
- *  @param[in] loc new location
+ *  @param[in] loc new location; characters which may not appear in a URI are percent-encoded
  *  @return a @c status header for the given HTTP code,
  *  @return followed by a @c Location header referencing the new location
  *  @throw std::invalid_argument code is not 3xx
@@ -47,8 +48,10 @@ std::string print_redir(unsigned code, const std::string& loc) {
 	if ((code / 100) != 3) {
 		throw std::invalid_argument("http_code must be 3xx (redirection-related)");
 	}
-	return status::print_status(code)
-		+ "Location: " + loc + "\r\n";
+	std::string r = status::print_status(code) + "Location: ";
+	percent_encode(r, loc, Percent::uri);
+	r += "\r\n";
+	return r;
 }
 
 //! Create a helper consisting of redirection generators
@@ -19,6 +19,7 @@
 
 #include <string>
 #include <sstream>
+#include <mosh/cgi/http/field_map.hpp>
 #include <mosh/cgi/http/helpers/helper.hpp>
 #include <mosh/cgi/http/helpers/status_helper.hpp>
 #include <mosh/cgi/http/helpers/status.hpp>
@@ -47,6 +48,26 @@ std::string print_status (unsigned st) {
 	return ss.str();
 }
 	
+/*! @brief Set the status of a rendered header block
+ *  Replaces the Status line if there is one, and prepends one otherwise.
+ *  @param[in,out] head header block, as rendered by @c Header
+ *  @param[in] st HTTP status code
+ */
+void set_status (std::string& head, unsigned st) {
+	const std::string line = print_status(st);
+	for (size_t pos = 0; pos < head.size(); ) {
+		const size_t eol = head.find("\r\n", pos);
+		if (eol == std::string::npos)
+			break;
+		if (eol - pos >= 7 && field_equal(head.data() + pos, 7, "Status:", 7)) {
+			head.replace(pos, eol + 2 - pos, line);
+			return;
+		}
+		pos = eol + 2;
+	}
+	head.insert(0, line);
+}
+
 //! Create a helper consisting of status line generators 
 Helper helper() {
 	Helper h;
@@ -17,51 +17,78 @@
  *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
  */
 
+#include <cstddef>
+#include <mutex>
 #include <stdexcept>
 #include <string>
-#include <utility>
 #include <mosh/cgi/html/sgml_doctype.hpp>
 #include <mosh/cgi/html/html_doctype.hpp>
+#include <mosh/cgi/bits/t_string.hpp>
 #include <mosh/cgi/bits/namespace.hpp>
 
 namespace {
 
-std::pair<std::string, std::string> w3c_fpi_uri(unsigned hr) {
-	using namespace MOSH_CGI::html::html_doctype::html_revision;
-	using std::make_pair;
-
-	switch (hr) {
-	case html_4_strict:
-		return make_pair("-//W3C//DTD HTML 4.01//EN", "http://www.w3.org/TR/html4/strict.dtd");
-	case html_4_frameset:
-		return make_pair("-//W3C//DTD HTML 4.01 Frameset//EN", "http://www.w3.org/TR/html4/frameset.dtd");
-	case html_4_transitional:
-		return make_pair("-//W3C//DTD HTML 4.01 Transitional//EN", "http://www.w3.org/TR/html4/loose.dtd");
-	case xhtml_10_strict:
-		return make_pair("-//W3C//DTD XHTML 1.0 Strict//EN", "http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd");
-	case xhtml_10_frameset:
-		return make_pair("-//W3C//DTD XHTML 1.0 Frameset//EN", "http://www.w3.org/TR/xhtml1/DTD/xhtml1-frameset.dtd");
-	case xhtml_10_transitional:
-		return make_pair("-//W3C//DTD XHTML 1.0 Transitional//EN", "http://www.w3.org/TR/xhtml1/DTD/xhtml1-transitional.dtd");
-	case xhtml_11:
-		return make_pair("-//W3C//DTD XHTML 1.1//EN", "http://www.w3.org/TR/xhtml11/DTD/xhtml11.dtd");
-	case xhtml_basic_10:
-		return make_pair("-//W3C//DTD XHTML Basic 1.0//EN", "http://www.w3.org/TR/xhtml-basic/xhtml-basic10.dtd");
-	case xhtml_basic_11:
-		return make_pair("-//W3C//DTD XHTML Basic 1.1//EN", "http://www.w3.org/TR/xhtml-basic/xhtml-basic11.dtd");
-	case xhtml_mp_10:
-		return make_pair("-//WAPFORUM//DTD XHTML Mobile 1.0//EN", "http://www.wapforum.org/DTD/xhtml-mobile10.dtd");
-	case xhtml_mp_11:
-		return make_pair("-//WAPFORUM//DTD XHTML Mobile 1.1//EN", "http://www.wapforum.org/DTD/xhtml-mobile11.dtd");
-	case xhtml_mp_12:
-		return make_pair("-//WAPFORUM//DTD XHTML Mobile 1.2//EN", "http://www.wapforum.org/DTD/xhtml-mobile12.dtd");
-	case html_5:
-		return make_pair("", ""); // HTML 5 is DTD-free
-	default:;
+using namespace MOSH_CGI::html::html_doctype::html_revision;
+
+//! Per-revision public identifiers
+struct Revision_info {
+	unsigned hr;
+	const char* fpi;
+	const char* uri;
+};
+
+const Revision_info revisions[] = {
+	{ html_4_strict, "-//W3C//DTD HTML 4.01//EN", "http://www.w3.org/TR/html4/strict.dtd" },
+	{ html_4_frameset, "-//W3C//DTD HTML 4.01 Frameset//EN", "http://www.w3.org/TR/html4/frameset.dtd" },
+	{ html_4_transitional, "-//W3C//DTD HTML 4.01 Transitional//EN", "http://www.w3.org/TR/html4/loose.dtd" },
+	{ xhtml_10_strict, "-//W3C//DTD XHTML 1.0 Strict//EN", "http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd" },
+	{ xhtml_10_frameset, "-//W3C//DTD XHTML 1.0 Frameset//EN", "http://www.w3.org/TR/xhtml1/DTD/xhtml1-frameset.dtd" },
+	{ xhtml_10_transitional, "-//W3C//DTD XHTML 1.0 Transitional//EN", "http://www.w3.org/TR/xhtml1/DTD/xhtml1-transitional.dtd" },
+	{ xhtml_11, "-//W3C//DTD XHTML 1.1//EN", "http://www.w3.org/TR/xhtml11/DTD/xhtml11.dtd" },
+	{ xhtml_basic_10, "-//W3C//DTD XHTML Basic 1.0//EN", "http://www.w3.org/TR/xhtml-basic/xhtml-basic10.dtd" },
+	{ xhtml_basic_11, "-//W3C//DTD XHTML Basic 1.1//EN", "http://www.w3.org/TR/xhtml-basic/xhtml-basic11.dtd" },
+	{ xhtml_mp_10, "-//WAPFORUM//DTD XHTML Mobile 1.0//EN", "http://www.wapforum.org/DTD/xhtml-mobile10.dtd" },
+	{ xhtml_mp_11, "-//WAPFORUM//DTD XHTML Mobile 1.1//EN", "http://www.wapforum.org/DTD/xhtml-mobile11.dtd" },
+	{ xhtml_mp_12, "-//WAPFORUM//DTD XHTML Mobile 1.2//EN", "http://www.wapforum.org/DTD/xhtml-mobile12.dtd" },
+	{ html_5, "", "" }, // HTML 5 is DTD-free
+};
+
+const size_t n_revisions = sizeof(revisions) / sizeof(revisions[0]);
+
+size_t find_revision(unsigned hr) {
+	for (size_t i = 0; i < n_revisions; ++i) {
+		if (revisions[i].hr == hr)
+			return i;
 	}
 	throw std::invalid_argument("doctype not found");
 }
 
+std::string identifier(const Revision_info& r) {
+	using namespace MOSH_CGI::html::sgml_doctype;
+	if (*r.fpi == '\0')
+		return std::string();
+	External_doctype_identifier<char> d(Declaration_identifier::_public, r.fpi, r.uri);
+	return d;
+}
+
+template <typename charT>
+void render_prologue(MOSH_CGI::html::html_doctype::Prologue<charT>& p, const Revision_info& r) {
+	using namespace MOSH_CGI;
+	const bool xhtml = (get_family(r.hr) == static_cast<uint8_t>(Family::xhtml));
+	std::string doctype = html::sgml_doctype::Doctype_declaration<char>("html", identifier(r));
+	std::string full;
+	if (xhtml) {
+		p.xml_declaration = wide_string<charT>("<?xml version=\"1.0\"?>");
+		p.xmlns = wide_string<charT>("xmlns=\"http://www.w3.org/1999/xhtml\"");
+		full = "<?xml version=\"1.0\"?>\r\n" + doctype
+			+ "\r\n<html xmlns=\"http://www.w3.org/1999/xhtml\">";
+	} else {
+		full = doctype + "\r\n<html>";
+	}
+	p.doctype = wide_string<charT>(doctype);
+	p.full = wide_string<charT>(full);
+}
+
 }
 
 MOSH_CGI_BEGIN
@@ -70,12 +97,26 @@ namespace html {
 namespace html_doctype {
 
 template<> std::string html_identifier<char>(unsigned hr) {
-	using namespace sgml_doctype;
-	auto fpi_uri = w3c_fpi_uri(hr);
-	External_doctype_identifier<char> d(Declaration_identifier::_public, fpi_uri.first, fpi_uri.second);
-	return d;
+	return identifier(revisions[find_revision(hr)]);
 }
 
+/*! @brief Get the pre-rendered prologue for an HTML revision
+ *  Each prologue is rendered on first use and cached for the lifetime of the process.
+ *  @param[in] hr HTML revision
+ *  @throw std::invalid_argument if hr is not a known revision
+ */
+template <typename charT>
+const Prologue<charT>& prologue(unsigned hr) {
+	static Prologue<charT> cache[n_revisions];
+	static std::once_flag rendered[n_revisions];
+	const size_t i = find_revision(hr);
+	std::call_once(rendered[i], [i] { render_prologue(cache[i], revisions[i]); });
+	return cache[i];
+}
+
+template const Prologue<char>& prologue<char>(unsigned);
+template const Prologue<wchar_t>& prologue<wchar_t>(unsigned);
+
 }
 }
 
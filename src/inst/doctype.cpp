@@ -0,0 +1,50 @@
+//! @file inst/doctype.cpp Instantiations of the doctype and XML declaration renderers
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <string>
+#include <mosh/cgi/html/sgml_doctype.hpp>
+#include <mosh/cgi/html/html_doctype.hpp>
+#include <mosh/cgi/html/xml_declaration.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+namespace html {
+
+namespace sgml_doctype {
+
+template class External_doctype_identifier<char>;
+template class External_doctype_identifier<wchar_t>;
+template class Doctype_declaration<char>;
+template class Doctype_declaration<wchar_t>;
+
+}
+
+namespace html_doctype {
+
+template std::wstring html_identifier<wchar_t>(unsigned);
+template sgml_doctype::Doctype_declaration<char> html_doctype<char>(unsigned);
+template sgml_doctype::Doctype_declaration<wchar_t> html_doctype<wchar_t>(unsigned);
+
+}
+
+template class XML_declaration<char>;
+template class XML_declaration<wchar_t>;
+
+}
+MOSH_CGI_END
@@ -0,0 +1,66 @@
+//! @file inst/element.cpp Instantiations of the element renderers
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <ostream>
+#include <mosh/cgi/html/element.hpp>
+#include <mosh/cgi/html/static_element.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+namespace html {
+namespace element {
+
+template class Element<char>;
+template class Element_prototype<char>;
+template class HTML_begin<char>;
+template class HTML_end<char>;
+template class Body_begin<char>;
+template class Body_end<char>;
+template class Element<wchar_t>;
+template class Element_prototype<wchar_t>;
+template class HTML_begin<wchar_t>;
+template class HTML_end<wchar_t>;
+template class Body_begin<wchar_t>;
+template class Body_end<wchar_t>;
+
+template class Element_base<char, Static_element<char>>;
+template class Element_base<char, Static_HTML_begin<char>>;
+template class Element_base<char, Static_body_begin<char>>;
+template class Static_element<char>;
+template class Static_HTML_begin<char>;
+template class Static_body_begin<char>;
+template class Element_base<wchar_t, Static_element<wchar_t>>;
+template class Element_base<wchar_t, Static_HTML_begin<wchar_t>>;
+template class Element_base<wchar_t, Static_body_begin<wchar_t>>;
+template class Static_element<wchar_t>;
+template class Static_HTML_begin<wchar_t>;
+template class Static_body_begin<wchar_t>;
+
+template std::basic_ostream<char>& operator << (std::basic_ostream<char>&, const Element<char>&);
+template std::basic_ostream<char>& operator << (std::basic_ostream<char>&, const Element_prototype<char>&);
+template std::basic_ostream<char>& operator << (std::basic_ostream<char>&, const HTML_end<char>&);
+template std::basic_ostream<char>& operator << (std::basic_ostream<char>&, const Body_end<char>&);
+template std::basic_ostream<wchar_t>& operator << (std::basic_ostream<wchar_t>&, const Element<wchar_t>&);
+template std::basic_ostream<wchar_t>& operator << (std::basic_ostream<wchar_t>&, const Element_prototype<wchar_t>&);
+template std::basic_ostream<wchar_t>& operator << (std::basic_ostream<wchar_t>&, const HTML_end<wchar_t>&);
+template std::basic_ostream<wchar_t>& operator << (std::basic_ostream<wchar_t>&, const Body_end<wchar_t>&);
+
+}
+}
+MOSH_CGI_END
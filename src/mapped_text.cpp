@@ -0,0 +1,154 @@
+//! @file mapped_text.cpp Large static content, mapped from files
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <mosh/cgi/html/mapped_text.hpp>
+#include <mosh/cgi/http/response.hpp>
+#include <mosh/cgi/bits/xxh64.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+namespace {
+
+//! A mapped file, and what it was when it was mapped
+struct Mapping {
+	Mapping()
+	: base(nullptr), size(0), hash(0), dev(0), ino(0), mtime()
+	{ }
+
+	~Mapping() {
+		if (base != nullptr)
+			::munmap(base, size);
+	}
+
+	bool current(const struct stat& st) const {
+		return st.st_dev == dev && st.st_ino == ino && static_cast<size_t>(st.st_size) == size
+			&& st.st_mtim.tv_sec == mtime.tv_sec && st.st_mtim.tv_nsec == mtime.tv_nsec;
+	}
+
+	void* base;
+	size_t size;
+	uint64_t hash;
+	dev_t dev;
+	ino_t ino;
+	timespec mtime;
+};
+
+//! Mappings by path
+struct Cache {
+	std::mutex lock;
+	std::unordered_map<std::string, std::shared_ptr<const Mapping>> map;
+};
+
+//! Made on first use, so that nothing runs before main()
+Cache& cache() {
+	static Cache c;
+	return c;
+}
+
+std::shared_ptr<const Mapping> map_file(const std::string& path) {
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return nullptr;
+	std::shared_ptr<Mapping> m(new Mapping);
+	struct stat st;
+	bool ok = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+	if (ok) {
+		m->size = st.st_size;
+		m->dev = st.st_dev;
+		m->ino = st.st_ino;
+		m->mtime = st.st_mtim;
+		if (m->size != 0) {
+			void* p = ::mmap(nullptr, m->size, PROT_READ, MAP_SHARED, fd, 0);
+			if (p == MAP_FAILED)
+				ok = false;
+			else
+				m->base = p;
+		}
+	}
+	::close(fd);
+	if (!ok)
+		return nullptr;
+	m->hash = MOSH_CGI::xxh64::hash(m->base, m->size);
+	return m;
+}
+
+}
+
+MOSH_CGI_BEGIN
+
+namespace html {
+
+Mapped_text::Mapped_text(const std::string& path)
+: _mapping(), _data(nullptr), _size(0), _hash(0)
+{
+	struct stat st;
+	const bool found = ::stat(path.c_str(), &st) == 0;
+	Cache& c = cache();
+	std::shared_ptr<const Mapping> m;
+	{
+		std::lock_guard<std::mutex> g(c.lock);
+		auto i = c.map.find(path);
+		if (i != c.map.end() && found && i->second->current(st))
+			m = i->second;
+	}
+	if (m == nullptr) {
+		m = map_file(path);
+		if (m == nullptr)
+			throw std::invalid_argument("MOSH_CGI::html::Mapped_text: cannot map " + path);
+		std::lock_guard<std::mutex> g(c.lock);
+		c.map[path] = m;
+	}
+	_data = static_cast<const char*>(m->base);
+	_size = m->size;
+	_hash = m->hash;
+	_mapping = m;
+}
+
+void Mapped_text::clear_cache() {
+	Cache& c = cache();
+	std::lock_guard<std::mutex> g(c.lock);
+	c.map.clear();
+}
+
+std::ostream& operator << (std::ostream& os, const Mapped_text& t) {
+	http::Response* r = dynamic_cast<http::Response*>(&os);
+	if (r == nullptr)
+		return os.write(t.data(), t.size());
+	if (!r->append(t.view(), t.mapping()))
+		os.setstate(std::ios_base::badbit);
+	return os;
+}
+
+}
+
+MOSH_CGI_END
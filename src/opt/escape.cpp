@@ -0,0 +1,280 @@
+//! @file opt/escape.cpp Context-aware escaping of untrusted text
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <mosh/cgi/html/escape.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/indices.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+namespace html {
+
+namespace {
+
+constexpr uint8_t bit(unsigned context) {
+	return static_cast<uint8_t>(1u << context);
+}
+
+constexpr bool is_alnum(unsigned c) {
+	return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+constexpr bool is_markup(unsigned c) {
+	return c == '&' || c == '<' || c == '>';
+}
+
+constexpr bool is_quote(unsigned c) {
+	return c == '"' || c == '\'';
+}
+
+constexpr bool is_css_safe(unsigned c) {
+	return c >= 0x80 || is_alnum(c) || c == ' ' || c == '-' || c == '_' || c == '.'
+		|| c == ',' || c == '#' || c == '%';
+}
+
+/* Which contexts a byte needs escaping in. Bytes from 0x80 up are UTF-8 code
+ * units: they are percent-encoded in URLs, and 0xE2 may start U+2028 or U+2029,
+ * which end a JavaScript string.
+ */
+constexpr uint8_t char_class(unsigned c) {
+	return (is_markup(c) ? bit(Context::text) : 0)
+		| ((is_markup(c) || is_quote(c)) ? bit(Context::attribute) : 0)
+		| ((c <= 0x20 || c >= 0x7F || is_markup(c) || is_quote(c) || c == '\\' || c == '`')
+			? bit(Context::url) : 0)
+		| ((c < 0x20 || c == 0x7F || c == 0xE2 || is_markup(c) || is_quote(c) || c == '\\')
+			? bit(Context::script) : 0)
+		| (is_css_safe(c) ? 0 : bit(Context::style));
+}
+
+struct Class_table {
+	uint8_t c[256];
+};
+
+template <size_t... I>
+constexpr Class_table make_class_table(Indices<I...>) {
+	return Class_table {{ char_class(I)... }};
+}
+
+constexpr Class_table class_table = make_class_table(Make_indices<256>::type());
+
+static_assert(class_table.c['a'] == 0, "letters never need escaping");
+static_assert(class_table.c['<'] == (bit(Context::text) | bit(Context::attribute) | bit(Context::url)
+	| bit(Context::script) | bit(Context::style)), "'<' needs escaping everywhere");
+
+inline uint8_t classify(char c) {
+	return class_table.c[static_cast<unsigned char>(c)];
+}
+
+// Wide characters are code points, not UTF-8 code units
+inline uint8_t classify(wchar_t c) {
+	if (static_cast<unsigned long>(c) < 0x80)
+		return class_table.c[c];
+	return bit(Context::url) | ((c == 0x2028 || c == 0x2029) ? bit(Context::script) : 0);
+}
+
+const char hex_digits[] = "0123456789ABCDEF";
+
+template <typename charT>
+void append_ascii(std::basic_string<charT>& out, const char* s) {
+	for (; *s; ++s)
+		out += static_cast<charT>(*s);
+}
+
+template <typename charT>
+void append_hex(std::basic_string<charT>& out, unsigned b) {
+	out += static_cast<charT>(hex_digits[(b >> 4) & 0xF]);
+	out += static_cast<charT>(hex_digits[b & 0xF]);
+}
+
+void append_percent(std::string& out, char c) {
+	out += '%';
+	append_hex(out, static_cast<unsigned char>(c));
+}
+
+// Percent-encode the UTF-8 form of a code point
+void append_percent(std::wstring& out, wchar_t c) {
+	unsigned long cp = static_cast<unsigned long>(c);
+	unsigned char b[4];
+	size_t n;
+	if (cp < 0x80) {
+		b[0] = cp;
+		n = 1;
+	} else if (cp < 0x800) {
+		b[0] = 0xC0 | (cp >> 6);
+		b[1] = 0x80 | (cp & 0x3F);
+		n = 2;
+	} else if (cp < 0x10000) {
+		b[0] = 0xE0 | (cp >> 12);
+		b[1] = 0x80 | ((cp >> 6) & 0x3F);
+		b[2] = 0x80 | (cp & 0x3F);
+		n = 3;
+	} else {
+		b[0] = 0xF0 | ((cp >> 18) & 0x07);
+		b[1] = 0x80 | ((cp >> 12) & 0x3F);
+		b[2] = 0x80 | ((cp >> 6) & 0x3F);
+		b[3] = 0x80 | (cp & 0x3F);
+		n = 4;
+	}
+	for (size_t i = 0; i < n; ++i) {
+		out += L'%';
+		append_hex(out, b[i]);
+	}
+}
+
+//! Compare the first n characters of s, ASCII-lowercased, to a lowercase name
+template <typename charT>
+bool lower_equals(Basic_string_view<charT> s, size_t n, const char* scheme) {
+	size_t i = 0;
+	for (; i < n && scheme[i]; ++i) {
+		charT c = s[i];
+		if (c >= 'A' && c <= 'Z')
+			c = c - 'A' + 'a';
+		if (c != static_cast<charT>(scheme[i]))
+			return false;
+	}
+	return i == n && !scheme[i];
+}
+
+//! Whether a URL is relative or has a scheme known to be harmless
+template <typename charT>
+bool allowed_url(Basic_string_view<charT> s) {
+	for (size_t i = 0; i < s.size(); ++i) {
+		charT c = s[i];
+		if (c == ':')
+			return lower_equals(s, i, "http") || lower_equals(s, i, "https") || lower_equals(s, i, "ftp")
+				|| lower_equals(s, i, "mailto") || lower_equals(s, i, "tel");
+		if (c == '/' || c == '?' || c == '#')
+			return true;
+	}
+	return true;
+}
+
+/* Append the escaped form of *p, which needs escaping in context; return the
+ * number of characters consumed.
+ */
+template <typename charT>
+size_t escape_one(std::basic_string<charT>& out, const charT* p, const charT* e, unsigned context) {
+	const charT c = *p;
+	switch (context) {
+	case Context::text:
+	case Context::attribute:
+		switch (c) {
+		case '&': append_ascii(out, "&amp;"); break;
+		case '<': append_ascii(out, "&lt;"); break;
+		case '>': append_ascii(out, "&gt;"); break;
+		case '"': append_ascii(out, "&quot;"); break;
+		default: append_ascii(out, "&#39;"); break;
+		}
+		return 1;
+	case Context::url:
+		if (c == '&')
+			append_ascii(out, "&amp;");
+		else
+			append_percent(out, c);
+		return 1;
+	case Context::script:
+		switch (c) {
+		case '\\': append_ascii(out, "\\\\"); return 1;
+		case '"': append_ascii(out, "\\\""); return 1;
+		case '\'': append_ascii(out, "\\'"); return 1;
+		case '\n': append_ascii(out, "\\n"); return 1;
+		case '\r': append_ascii(out, "\\r"); return 1;
+		case '\t': append_ascii(out, "\\t"); return 1;
+		default:;
+		}
+		if (sizeof(charT) == 1 && static_cast<unsigned char>(c) == 0xE2) {
+			// U+2028 and U+2029 are E2 80 A8 and E2 80 A9
+			if (e - p >= 3 && static_cast<unsigned char>(p[1]) == 0x80
+					&& (static_cast<unsigned char>(p[2]) & 0xFE) == 0xA8) {
+				append_ascii(out, (static_cast<unsigned char>(p[2]) == 0xA8) ? "\\u2028" : "\\u2029");
+				return 3;
+			}
+			out += c;
+			return 1;
+		}
+		if (static_cast<unsigned long>(c) == 0x2028 || static_cast<unsigned long>(c) == 0x2029) {
+			append_ascii(out, (static_cast<unsigned long>(c) == 0x2028) ? "\\u2028" : "\\u2029");
+			return 1;
+		}
+		append_ascii(out, "\\x");
+		append_hex(out, static_cast<unsigned>(c));
+		return 1;
+	default:
+		out += static_cast<charT>('\\');
+		append_hex(out, static_cast<unsigned>(c));
+		out += static_cast<charT>(' ');
+		return 1;
+	}
+}
+
+}
+
+/*! @brief Get the context of the content of an element
+ *  @param[in] name element name
+ */
+unsigned element_context(String_view name) {
+	if (name.size() == 6 && lower_equals(name, 6, "script"))
+		return Context::script;
+	if (name.size() == 5 && lower_equals(name, 5, "style"))
+		return Context::style;
+	return Context::text;
+}
+
+template <typename charT>
+size_t safe_prefix(Basic_string_view<charT> s, unsigned context) {
+	if (context == Context::url && !allowed_url(s))
+		return 0;
+	const uint8_t mask = bit(context);
+	size_t i = 0;
+	while (i < s.size() && !(classify(s[i]) & mask))
+		++i;
+	return i;
+}
+
+template <typename charT>
+void escape(std::basic_string<charT>& out, Basic_string_view<charT> s, unsigned context) {
+	if (context == Context::url && !allowed_url(s)) {
+		append_ascii(out, "about:invalid");
+		return;
+	}
+	const uint8_t mask = bit(context);
+	const charT* p = s.begin();
+	const charT* const e = s.end();
+	out.reserve(out.size() + s.size());
+	while (p != e) {
+		const charT* q = p;
+		while (q != e && !(classify(*q) & mask))
+			++q;
+		out.append(p, q);
+		if (q == e)
+			break;
+		p = q + escape_one(out, q, e, context);
+	}
+}
+
+template size_t safe_prefix<char>(String_view, unsigned);
+template size_t safe_prefix<wchar_t>(WString_view, unsigned);
+template void escape<char>(std::string&, String_view, unsigned);
+template void escape<wchar_t>(std::wstring&, WString_view, unsigned);
+
+}
+MOSH_CGI_END
@@ -0,0 +1,766 @@
+//! @file opt/http_misc.cpp Implementation for http/misc functions
+/*!*************************************************************************
+* Copyright (C) 2011 m0shbear                                              *
+*                                                                          *
+* This file is part of mosh-cgi.                                           *
+*                                                                          *
+* This library is free software: you can redistribute it and/or modify it  *
+* under the terms of the GNU Lesser General Public License as  published   *
+* by the Free Software Foundation, either version 3 of the License, or (at *
+* your option) any later version.                                          *
+*                                                                          *
+* This library is distributed in the hope that it will be useful, but      *
+* WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser *
+* General Public License for more details.                                 *
+*                                                                          *
+* You should have received a copy of the GNU Lesser General Public License *
+* along with mosh-cgi.  If not, see <http://www.gnu.org/licenses/>.       *
+****************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <mosh/cgi/http/misc.hpp>
+#include <mosh/fcgi/http/misc.hpp>
+#include <mosh/cgi/bits/indices.hpp>
+#include <mosh/cgi/bits/cpu.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+#include <mosh/fcgi/bits/namespace.hpp>
+
+#ifdef MOSH_CGI_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using namespace MOSH_CGI::http;
+
+constexpr uint8_t bit(unsigned mode) {
+	return static_cast<uint8_t>(1u << mode);
+}
+
+constexpr bool is_unreserved(unsigned c) {
+	return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')
+		|| c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+constexpr bool is_uri_illegal(unsigned c) {
+	return c <= 0x20 || c >= 0x7F || c == '"' || c == '<' || c == '>' || c == '\\'
+		|| c == '^' || c == '`' || c == '{' || c == '|' || c == '}';
+}
+
+//! Which modes a byte is encoded in
+constexpr uint8_t encode_class(unsigned c) {
+	return (is_unreserved(c) ? 0 : (bit(Percent::component) | bit(Percent::form)))
+		| (is_uri_illegal(c) ? bit(Percent::uri) : 0);
+}
+
+struct Class_table {
+	uint8_t c[256];
+};
+
+template <size_t... I>
+constexpr Class_table make_encode_table(MOSH_CGI::Indices<I...>) {
+	return Class_table {{ encode_class(I)... }};
+}
+
+constexpr Class_table encode_table = make_encode_table(MOSH_CGI::Make_indices<256>::type());
+
+constexpr int hex_value(unsigned c) {
+	return (c >= '0' && c <= '9') ? static_cast<int>(c - '0')
+		: (c >= 'A' && c <= 'F') ? static_cast<int>(c - 'A' + 10)
+		: (c >= 'a' && c <= 'f') ? static_cast<int>(c - 'a' + 10) : -1;
+}
+
+struct Hex_table {
+	int8_t v[256];
+};
+
+template <size_t... I>
+constexpr Hex_table make_hex_table(MOSH_CGI::Indices<I...>) {
+	return Hex_table {{ static_cast<int8_t>(hex_value(I))... }};
+}
+
+constexpr Hex_table hex_table = make_hex_table(MOSH_CGI::Make_indices<256>::type());
+
+const char hex_digits[] = "0123456789ABCDEF";
+
+inline uint8_t u8(char c) {
+	return static_cast<uint8_t>(c);
+}
+
+typedef const char* (*find_unsafe_fn)(const char*, const char*, unsigned);
+typedef const char* (*find_form_escape_fn)(const char*, const char*);
+
+//! Next byte at or after p which percent_encode() escapes in mode
+const char* find_unsafe_generic(const char* p, const char* e, unsigned mode) {
+	const uint8_t mask = bit(mode);
+	while (p != e && !(encode_table.c[u8(*p)] & mask))
+		++p;
+	return p;
+}
+
+//! Next '%' or '+' at or after p
+const char* find_form_escape_generic(const char* p, const char* e) {
+	while (p != e && *p != '%' && *p != '+')
+		++p;
+	return p;
+}
+
+#ifdef MOSH_CGI_X86_KERNELS
+/* There are no unsigned byte compares before AVX-512, so a byte is tested for
+ * [lo, hi] as min(x - lo, hi - lo) == x - lo.
+ */
+MOSH_CGI_TARGET("sse2")
+inline __m128i in_range_sse2(__m128i x, char lo, char hi) {
+	const __m128i d = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+	return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(static_cast<char>(hi - lo))), d);
+}
+
+MOSH_CGI_TARGET("sse2")
+inline __m128i is_sse2(__m128i x, char c) {
+	return _mm_cmpeq_epi8(x, _mm_set1_epi8(c));
+}
+
+//! Bytes kept as is in Percent::component and Percent::form
+MOSH_CGI_TARGET("sse2")
+inline __m128i unreserved_sse2(__m128i x) {
+	return _mm_or_si128(
+		_mm_or_si128(in_range_sse2(x, '0', '9'), in_range_sse2(x, 'A', 'Z')),
+		_mm_or_si128(_mm_or_si128(in_range_sse2(x, 'a', 'z'), in_range_sse2(x, '-', '.')),
+			_mm_or_si128(is_sse2(x, '_'), is_sse2(x, '~'))));
+}
+
+//! Bytes kept as is in Percent::uri
+MOSH_CGI_TARGET("sse2")
+inline __m128i uri_legal_sse2(__m128i x) {
+	const __m128i bad = _mm_or_si128(
+		_mm_or_si128(_mm_or_si128(is_sse2(x, '"'), is_sse2(x, '<')),
+			_mm_or_si128(is_sse2(x, '>'), is_sse2(x, '\\'))),
+		_mm_or_si128(_mm_or_si128(is_sse2(x, '^'), is_sse2(x, '`')),
+			in_range_sse2(x, '{', '}')));
+	return _mm_andnot_si128(bad, in_range_sse2(x, 0x21, 0x7E));
+}
+
+MOSH_CGI_TARGET("sse2")
+const char* find_unsafe_sse2(const char* p, const char* e, unsigned mode) {
+	const bool uri = mode == Percent::uri;
+	for (; e - p >= 16; p += 16) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		const unsigned m = ~_mm_movemask_epi8(uri ? uri_legal_sse2(x) : unreserved_sse2(x)) & 0xFFFF;
+		if (m != 0)
+			return p + __builtin_ctz(m);
+	}
+	return find_unsafe_generic(p, e, mode);
+}
+
+MOSH_CGI_TARGET("sse2")
+const char* find_form_escape_sse2(const char* p, const char* e) {
+	for (; e - p >= 16; p += 16) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		const int m = _mm_movemask_epi8(_mm_or_si128(is_sse2(x, '%'), is_sse2(x, '+')));
+		if (m != 0)
+			return p + __builtin_ctz(m);
+	}
+	return find_form_escape_generic(p, e);
+}
+
+MOSH_CGI_TARGET("avx2")
+inline __m256i in_range_avx2(__m256i x, char lo, char hi) {
+	const __m256i d = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+	return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(static_cast<char>(hi - lo))), d);
+}
+
+MOSH_CGI_TARGET("avx2")
+inline __m256i is_avx2(__m256i x, char c) {
+	return _mm256_cmpeq_epi8(x, _mm256_set1_epi8(c));
+}
+
+MOSH_CGI_TARGET("avx2")
+inline __m256i unreserved_avx2(__m256i x) {
+	return _mm256_or_si256(
+		_mm256_or_si256(in_range_avx2(x, '0', '9'), in_range_avx2(x, 'A', 'Z')),
+		_mm256_or_si256(_mm256_or_si256(in_range_avx2(x, 'a', 'z'), in_range_avx2(x, '-', '.')),
+			_mm256_or_si256(is_avx2(x, '_'), is_avx2(x, '~'))));
+}
+
+MOSH_CGI_TARGET("avx2")
+inline __m256i uri_legal_avx2(__m256i x) {
+	const __m256i bad = _mm256_or_si256(
+		_mm256_or_si256(_mm256_or_si256(is_avx2(x, '"'), is_avx2(x, '<')),
+			_mm256_or_si256(is_avx2(x, '>'), is_avx2(x, '\\'))),
+		_mm256_or_si256(_mm256_or_si256(is_avx2(x, '^'), is_avx2(x, '`')),
+			in_range_avx2(x, '{', '}')));
+	return _mm256_andnot_si256(bad, in_range_avx2(x, 0x21, 0x7E));
+}
+
+MOSH_CGI_TARGET("avx2")
+const char* find_unsafe_avx2(const char* p, const char* e, unsigned mode) {
+	const bool uri = mode == Percent::uri;
+	for (; e - p >= 32; p += 32) {
+		const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		const unsigned m = ~static_cast<unsigned>(
+			_mm256_movemask_epi8(uri ? uri_legal_avx2(x) : unreserved_avx2(x)));
+		if (m != 0)
+			return p + __builtin_ctz(m);
+	}
+	return find_unsafe_sse2(p, e, mode);
+}
+
+MOSH_CGI_TARGET("avx2")
+const char* find_form_escape_avx2(const char* p, const char* e) {
+	for (; e - p >= 32; p += 32) {
+		const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		const unsigned m = static_cast<unsigned>(
+			_mm256_movemask_epi8(_mm256_or_si256(is_avx2(x, '%'), is_avx2(x, '+'))));
+		if (m != 0)
+			return p + __builtin_ctz(m);
+	}
+	return find_form_escape_sse2(p, e);
+}
+#else
+const find_unsafe_fn find_unsafe_sse2 = nullptr;
+const find_unsafe_fn find_unsafe_avx2 = nullptr;
+const find_form_escape_fn find_form_escape_sse2 = nullptr;
+const find_form_escape_fn find_form_escape_avx2 = nullptr;
+#endif
+
+find_unsafe_fn find_unsafe() {
+	static const find_unsafe_fn f = MOSH_CGI::cpu::select<find_unsafe_fn>(find_unsafe_generic,
+		find_unsafe_sse2, find_unsafe_avx2);
+	return f;
+}
+
+find_form_escape_fn find_form_escape() {
+	static const find_form_escape_fn f = MOSH_CGI::cpu::select<find_form_escape_fn>(
+		find_form_escape_generic, find_form_escape_sse2, find_form_escape_avx2);
+	return f;
+}
+
+//! Next byte at or after p which a decoder has to look at
+inline const char* find_escape(const char* p, const char* e, unsigned mode) {
+	if (mode != Percent::form) {
+		// libc's memchr() is vectorised already
+		const void* q = std::memchr(p, '%', e - p);
+		return (q == nullptr) ? e : static_cast<const char*>(q);
+	}
+	return find_form_escape()(p, e);
+}
+
+const char base64_digits[2][65] = {
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+};
+
+//! Value of a base64 digit of either alphabet, or -1
+constexpr int base64_value(unsigned c) {
+	return (c >= 'A' && c <= 'Z') ? static_cast<int>(c - 'A')
+		: (c >= 'a' && c <= 'z') ? static_cast<int>(c - 'a' + 26)
+		: (c >= '0' && c <= '9') ? static_cast<int>(c - '0' + 52)
+		: (c == '+' || c == '-') ? 62
+		: (c == '/' || c == '_') ? 63 : -1;
+}
+
+struct Base64_table {
+	int8_t v[256];
+};
+
+template <size_t... I>
+constexpr Base64_table make_base64_table(MOSH_CGI::Indices<I...>) {
+	return Base64_table {{ static_cast<int8_t>(base64_value(I))... }};
+}
+
+constexpr Base64_table base64_table = make_base64_table(MOSH_CGI::Make_indices<256>::type());
+
+inline int b64(char c) {
+	return base64_table.v[u8(c)];
+}
+
+/* Base64 kernels take whole groups from p (three bytes, or four digits) and
+ * advance o past their output. They return where they stopped; the caller
+ * handles the rest. The decoders stop at the first bad digit and throw.
+ */
+typedef const char* (*base64_encode_fn)(char*&, const char*, const char*, const char*);
+typedef const char* (*base64_decode_fn)(char*&, const char*, const char*);
+
+const char* base64_encode_generic(char*& o, const char* p, const char* e, const char* d) {
+	for (; e - p >= 3; p += 3, o += 4) {
+		const uint32_t v = (u8(p[0]) << 16) | (u8(p[1]) << 8) | u8(p[2]);
+		o[0] = d[v >> 18];
+		o[1] = d[(v >> 12) & 0x3F];
+		o[2] = d[(v >> 6) & 0x3F];
+		o[3] = d[v & 0x3F];
+	}
+	return p;
+}
+
+const char* base64_decode_generic(char*& o, const char* p, const char* e) {
+	for (; e - p >= 4; p += 4, o += 3) {
+		const int a = b64(p[0]), b = b64(p[1]), c = b64(p[2]), d = b64(p[3]);
+		if ((a | b | c | d) < 0)
+			throw std::invalid_argument("MOSH_CGI::http::base64_decode: bad digit");
+		const uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+		o[0] = static_cast<char>(v >> 16);
+		o[1] = static_cast<char>(v >> 8);
+		o[2] = static_cast<char>(v);
+	}
+	return p;
+}
+
+#ifdef MOSH_CGI_X86_KERNELS
+/* 24 bytes to 32 digits and back per step, after Muła and Lemire, "Faster
+ * Base64 Encoding and Decoding Using AVX2 Instructions". Both need byte
+ * shuffles, which SSE2 lacks, so there are no SSE2 versions.
+ */
+MOSH_CGI_TARGET("avx2")
+const char* base64_encode_avx2(char*& o, const char* p, const char* e, const char* d) {
+	// Offset from each 6-bit value to its digit, by the class lookup() below puts it in
+	const __m256i shift = _mm256_setr_epi8(
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, d[62] - 62, d[63] - 63, 'A', 0, 0,
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, d[62] - 62, d[63] - 63, 'A', 0, 0);
+	// Each 32-bit lane gets bytes 1 0 2 1 of its group
+	const __m256i spread = _mm256_setr_epi8(
+		1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+		1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	// Each lane reads 16 bytes for 12, so stop while 28 are left
+	for (; e - p >= 28; p += 24, o += 32) {
+		__m256i x = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+		x = _mm256_shuffle_epi8(x, spread);
+		// Move the four 6-bit fields of each lane into its four bytes
+		const __m256i hi = _mm256_mulhi_epu16(_mm256_and_si256(x, _mm256_set1_epi32(0x0FC0FC00)),
+			_mm256_set1_epi32(0x04000040));
+		const __m256i lo = _mm256_mullo_epi16(_mm256_and_si256(x, _mm256_set1_epi32(0x003F03F0)),
+			_mm256_set1_epi32(0x01000010));
+		const __m256i v = _mm256_or_si256(hi, lo);
+		// Class: 13 for A-Z, 0 for a-z, 1-10 for 0-9, 11 and 12 for the last two
+		__m256i c = _mm256_subs_epu8(v, _mm256_set1_epi8(51));
+		c = _mm256_or_si256(c, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), v),
+			_mm256_set1_epi8(13)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(o),
+			_mm256_add_epi8(v, _mm256_shuffle_epi8(shift, c)));
+	}
+	return base64_encode_generic(o, p, e, d);
+}
+
+MOSH_CGI_TARGET("avx2")
+const char* base64_decode_avx2(char*& o, const char* p, const char* e) {
+	const __m256i gather = _mm256_setr_epi8(
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	for (; e - p >= 32; p += 32, o += 24) {
+		const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		const __m256i upper = in_range_avx2(x, 'A', 'Z');
+		const __m256i lower = in_range_avx2(x, 'a', 'z');
+		const __m256i digit = in_range_avx2(x, '0', '9');
+		// Either alphabet, as b64()
+		const __m256i v62 = _mm256_or_si256(is_avx2(x, '+'), is_avx2(x, '-'));
+		const __m256i v63 = _mm256_or_si256(is_avx2(x, '/'), is_avx2(x, '_'));
+		const __m256i alnum = _mm256_or_si256(_mm256_or_si256(upper, lower), digit);
+		if (~_mm256_movemask_epi8(_mm256_or_si256(alnum, _mm256_or_si256(v62, v63))) != 0)
+			break;
+		const __m256i offset = _mm256_or_si256(
+			_mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+				_mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+			_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+		const __m256i v = _mm256_or_si256(
+			_mm256_and_si256(alnum, _mm256_add_epi8(x, offset)),
+			_mm256_or_si256(_mm256_and_si256(v62, _mm256_set1_epi8(62)),
+				_mm256_and_si256(v63, _mm256_set1_epi8(63))));
+		// Join 6-bit values in pairs, then the pairs, into 24 bits per lane
+		const __m256i pairs = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+		const __m256i words = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+		// Big-endian 3-byte groups, packed into the low 24 bytes
+		const __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(words, gather),
+			_mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm256_castsi256_si128(bytes));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(o + 16), _mm256_extracti128_si256(bytes, 1));
+	}
+	return base64_decode_generic(o, p, e);
+}
+#else
+const base64_encode_fn base64_encode_avx2 = nullptr;
+const base64_decode_fn base64_decode_avx2 = nullptr;
+#endif
+
+base64_encode_fn base64_encoder() {
+	static const base64_encode_fn f = MOSH_CGI::cpu::select<base64_encode_fn>(
+		base64_encode_generic, nullptr, base64_encode_avx2);
+	return f;
+}
+
+base64_decode_fn base64_decoder() {
+	static const base64_decode_fn f = MOSH_CGI::cpu::select<base64_decode_fn>(
+		base64_decode_generic, nullptr, base64_decode_avx2);
+	return f;
+}
+
+
+const char weekdays[] = "SunMonTueWedThuFriSat";
+const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+//! Number of days in month m (1-12) of year y
+unsigned days_in_month(int64_t y, unsigned m) {
+	if (m == 2)
+		return (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)) ? 29 : 28;
+	return (m == 4 || m == 6 || m == 9 || m == 11) ? 30 : 31;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (Howard Hinnant's algorithm)
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+	y -= m <= 2;
+	const int64_t era = (y >= 0 ? y : y - 399) / 400;
+	const unsigned yoe = static_cast<unsigned>(y - era * 400);
+	const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+	z += 719468;
+	const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+	const unsigned doe = static_cast<unsigned>(z - era * 146097);
+	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const unsigned mp = (5 * doy + 2) / 153;
+	d = doy - (153 * mp + 2) / 5 + 1;
+	m = mp < 10 ? mp + 3 : mp - 9;
+	y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+inline void put2(char* p, unsigned v) {
+	p[0] = '0' + v / 10;
+	p[1] = '0' + v % 10;
+}
+
+//! Cursor over a date being parsed
+struct Date_reader {
+	const char* p;
+	const char* e;
+
+	bool lit(char c) {
+		if (p == e || *p != c)
+			return false;
+		++p;
+		return true;
+	}
+
+	bool lit(const char* s) {
+		for (; *s; ++s)
+			if (!lit(*s))
+				return false;
+		return true;
+	}
+
+	//! Exactly n digits
+	bool num(unsigned n, unsigned& v) {
+		v = 0;
+		for (; n != 0; --n, ++p) {
+			if (p == e || *p < '0' || *p > '9')
+				return false;
+			v = v * 10 + (*p - '0');
+		}
+		return true;
+	}
+
+	//! Month name, as 1-12
+	bool month(unsigned& m) {
+		if (e - p < 3)
+			return false;
+		for (m = 0; m < 12; ++m) {
+			if (!std::memcmp(p, months + 3 * m, 3)) {
+				p += 3;
+				++m;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//! "HH:MM:SS"
+	bool clock(unsigned& h, unsigned& mi, unsigned& s) {
+		return num(2, h) && lit(':') && num(2, mi) && lit(':') && num(2, s);
+	}
+
+	//! Whether only whitespace is left
+	bool end() {
+		while (p != e && (*p == ' ' || *p == '\t'))
+			++p;
+		return p == e;
+	}
+};
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+//! Prints the current UTC time, in microsecond resolution to a string, with format fmt
+std::string time_to_string(const std::string& fmt, unsigned long add_seconds) {
+	return MOSH_FCGI::http::time_to_string(fmt, add_seconds);
+}
+
+/*! @brief Format an HTTP date
+ *  @param[out] out buffer of at least http_date_size bytes; not NUL-terminated
+ *  @param[in] t time
+ */
+void format_http_date(char* out, time_t t) {
+	int64_t days = t / 86400;
+	int64_t secs = t % 86400;
+	if (secs < 0) {
+		secs += 86400;
+		--days;
+	}
+	int64_t y;
+	unsigned m, d;
+	civil_from_days(days, y, m, d);
+	const unsigned wd = static_cast<unsigned>(((days % 7) + 11) % 7);
+	std::memcpy(out, "Thu, 01 Jan 1970 00:00:00 GMT", http_date_size);
+	std::memcpy(out, weekdays + 3 * wd, 3);
+	put2(out + 5, d);
+	std::memcpy(out + 8, months + 3 * (m - 1), 3);
+	put2(out + 12, static_cast<unsigned>(y / 100 % 100));
+	put2(out + 14, static_cast<unsigned>(y % 100));
+	put2(out + 17, static_cast<unsigned>(secs / 3600));
+	put2(out + 20, static_cast<unsigned>(secs / 60 % 60));
+	put2(out + 23, static_cast<unsigned>(secs % 60));
+}
+
+/*! @brief Format an HTTP date
+ *  @param[in] t time
+ */
+std::string http_date(time_t t) {
+	char b[http_date_size];
+	format_http_date(b, t);
+	return std::string(b, sizeof(b));
+}
+
+/*! @brief Parse an HTTP date
+ *  @param[in] s date, in IMF-fixdate, RFC 850 or asctime format
+ *  @param[out] t time
+ *  @retval false if s is not a valid date, in which case t is unchanged
+ */
+bool parse_http_date(String_view s, time_t& t) {
+	Date_reader r { s.begin(), s.end() };
+	while (r.p != r.e && (*r.p == ' ' || *r.p == '\t'))
+		++r.p;
+	const char* comma = static_cast<const char*>(std::memchr(r.p, ',', r.e - r.p));
+	unsigned y, m, d, h, mi, sec;
+	if (comma != nullptr) {
+		r.p = comma + 1;
+		if (!r.lit(' ') || !r.num(2, d))
+			return false;
+		if (r.lit(' ')) {
+			// IMF-fixdate: "Sun, 06 Nov 1994 08:49:37 GMT"
+			if (!r.month(m) || !r.lit(' ') || !r.num(4, y))
+				return false;
+		} else {
+			// RFC 850: "Sunday, 06-Nov-94 08:49:37 GMT"
+			if (!r.lit('-') || !r.month(m) || !r.lit('-') || !r.num(2, y))
+				return false;
+			y += (y < 70) ? 2000 : 1900;
+		}
+		if (!r.lit(' ') || !r.clock(h, mi, sec) || !r.lit(" GMT"))
+			return false;
+	} else {
+		// asctime: "Sun Nov  6 08:49:37 1994"
+		r.p += (r.e - r.p < 4) ? r.e - r.p : 4;
+		if (!r.month(m) || !r.lit(' '))
+			return false;
+		if (r.lit(' ')) {
+			if (!r.num(1, d))
+				return false;
+		} else if (!r.num(2, d)) {
+			return false;
+		}
+		if (!r.lit(' ') || !r.clock(h, mi, sec) || !r.lit(' ') || !r.num(4, y))
+			return false;
+	}
+	if (!r.end() || d < 1 || d > days_in_month(y, m) || h > 23 || mi > 59 || sec > 60)
+		return false;
+	t = static_cast<time_t>(days_from_civil(y, m, d) * 86400 + h * 3600 + mi * 60 + sec);
+	return true;
+}
+
+/*! @brief Percent-encode
+ *  @param[out] out buffer of at least percent_encoded_max(in.size()) bytes
+ *  @param[in] in input
+ *  @param[in] mode one of Percent
+ *  @return number of bytes written
+ */
+size_t percent_encode(char* out, String_view in, unsigned mode) {
+	const find_unsafe_fn find = find_unsafe();
+	const char* p = in.begin();
+	const char* const e = in.end();
+	char* o = out;
+	while (p != e) {
+		const char* q = find(p, e, mode);
+		std::memcpy(o, p, q - p);
+		o += q - p;
+		if (q == e)
+			break;
+		if (*q == ' ' && mode == Percent::form) {
+			*o++ = '+';
+		} else {
+			*o++ = '%';
+			*o++ = hex_digits[u8(*q) >> 4];
+			*o++ = hex_digits[u8(*q) & 0xF];
+		}
+		p = q + 1;
+	}
+	return o - out;
+}
+
+/*! @brief Percent-encode, appending to a string
+ *  @param[in,out] out string to append to
+ *  @param[in] in input
+ *  @param[in] mode one of Percent
+ */
+void percent_encode(std::string& out, String_view in, unsigned mode) {
+	const size_t n = out.size();
+	out.resize(n + percent_encoded_max(in.size()));
+	out.resize(n + percent_encode(&out[n], in, mode));
+}
+
+/*! @brief Percent-decode
+ *  @param[out] out buffer of at least in.size() bytes
+ *  @param[in] in input
+ *  @param[in] mode Percent::form to decode '+' as a space
+ *  @return number of bytes written
+ */
+size_t percent_decode(char* out, String_view in, unsigned mode) {
+	const char* p = in.begin();
+	const char* const e = in.end();
+	char* o = out;
+	while (p != e) {
+		const char* q = find_escape(p, e, mode);
+		if (o != p)
+			std::memmove(o, p, q - p);
+		o += q - p;
+		if (q == e)
+			break;
+		if (*q == '+') {
+			*o++ = ' ';
+			p = q + 1;
+			continue;
+		}
+		int hi = (e - q > 2) ? hex_table.v[u8(q[1])] : -1;
+		int lo = (hi >= 0) ? hex_table.v[u8(q[2])] : -1;
+		if (lo < 0) {
+			*o++ = '%';
+			p = q + 1;
+			continue;
+		}
+		*o++ = static_cast<char>((hi << 4) | lo);
+		p = q + 3;
+	}
+	return o - out;
+}
+
+/*! @brief Percent-decode, appending to a string
+ *  @param[in,out] out string to append to
+ *  @param[in] in input
+ *  @param[in] mode Percent::form to decode '+' as a space
+ */
+void percent_decode(std::string& out, String_view in, unsigned mode) {
+	const size_t n = out.size();
+	out.resize(n + in.size());
+	out.resize(n + percent_decode(&out[n], in, mode));
+}
+
+/*! @brief Base64-encode
+ *  @param[out] out buffer of at least base64_encoded_size(in.size(), alphabet) bytes
+ *  @param[in] in input
+ *  @param[in] alphabet one of Base64
+ *  @return number of bytes written
+ */
+size_t base64_encode(char* out, String_view in, unsigned alphabet) {
+	const char* const d = base64_digits[(alphabet == Base64::url) ? 1 : 0];
+	const char* p = in.begin();
+	const char* const e = in.end();
+	char* o = out;
+	p = base64_encoder()(o, p, e, d);
+	if (p != e) {
+		const uint32_t v = (u8(p[0]) << 16) | ((e - p == 2) ? (u8(p[1]) << 8) : 0);
+		*o++ = d[v >> 18];
+		*o++ = d[(v >> 12) & 0x3F];
+		if (e - p == 2)
+			*o++ = d[(v >> 6) & 0x3F];
+		if (alphabet != Base64::url) {
+			if (e - p == 1)
+				*o++ = '=';
+			*o++ = '=';
+		}
+	}
+	return o - out;
+}
+
+/*! @brief Base64-encode, appending to a string
+ *  @param[in,out] out string to append to
+ *  @param[in] in input
+ *  @param[in] alphabet one of Base64
+ */
+void base64_encode(std::string& out, String_view in, unsigned alphabet) {
+	const size_t n = out.size();
+	out.resize(n + base64_encoded_size(in.size(), alphabet));
+	base64_encode(&out[n], in, alphabet);
+}
+
+/*! @brief Base64-decode
+ *  @param[out] out buffer of at least base64_decoded_max(in.size()) bytes
+ *  @param[in] in input
+ *  @return number of bytes written
+ *  @throw std::invalid_argument if in is not valid base64
+ */
+size_t base64_decode(char* out, String_view in) {
+	const char* p = in.begin();
+	const char* e = in.end();
+	if (e - p >= 4 && (e - p) % 4 == 0) {
+		if (e[-1] == '=')
+			--e;
+		if (e[-1] == '=')
+			--e;
+	}
+	if ((e - p) % 4 == 1)
+		throw std::invalid_argument("MOSH_CGI::http::base64_decode: bad length");
+	char* o = out;
+	p = base64_decoder()(o, p, e);
+	if (p != e) {
+		const int a = b64(p[0]), b = b64(p[1]), c = (e - p == 3) ? b64(p[2]) : 0;
+		if ((a | b | c) < 0)
+			throw std::invalid_argument("MOSH_CGI::http::base64_decode: bad digit");
+		const uint32_t v = (a << 18) | (b << 12) | (c << 6);
+		*o++ = static_cast<char>(v >> 16);
+		if (e - p == 3)
+			*o++ = static_cast<char>(v >> 8);
+	}
+	return o - out;
+}
+
+/*! @brief Base64-decode, appending to a string
+ *  @param[in,out] out string to append to
+ *  @param[in] in input
+ *  @throw std::invalid_argument if in is not valid base64
+ */
+void base64_decode(std::string& out, String_view in) {
+	const size_t n = out.size();
+	out.resize(n + base64_decoded_max(in.size()));
+	try {
+		out.resize(n + base64_decode(&out[n], in));
+	} catch (...) {
+		out.resize(n);
+		throw;
+	}
+}
+
+}
+
+MOSH_CGI_END
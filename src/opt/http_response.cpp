@@ -0,0 +1,527 @@
+//! @file opt/http_response.cpp Buffered response with Content-Length
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+#include <mosh/cgi/http/response.hpp>
+#include <mosh/cgi/http/field_map.hpp>
+#include <mosh/cgi/http/header.hpp>
+#include <mosh/cgi/http/range.hpp>
+#include <mosh/cgi/http/helpers/status_helper.hpp>
+#include <mosh/cgi/bits/fd_io.hpp>
+#include <mosh/cgi/bits/xxh64.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+extern "C" {
+#include <sys/uio.h>
+#include <unistd.h>
+}
+
+namespace {
+
+//! Most blocks to gather for one writev(); well below any IOV_MAX
+const size_t max_blocks = 64;
+
+//! Whether a response with this Status has a body, and so a Content-Length
+bool has_body(const std::string* status) {
+	return status == nullptr || !((*status)[0] == '1' || !status->compare(0, 3, "204")
+		|| !status->compare(0, 3, "304"));
+}
+
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+Response::Response(std::ostream& out_, size_t threshold, unsigned overflow)
+: std::ostream(nullptr), header(), out(&out_), fd(-1), head(), buf(*this, threshold, overflow),
+	finished(false), accept_ranges(false), range(), byte_ranges(), slices(), part_heads(), part_marks()
+{
+	rdbuf(&buf);
+}
+
+Response::Response(int fd_, size_t threshold, unsigned overflow)
+: std::ostream(nullptr), header(), out(nullptr), fd(fd_), head(), buf(*this, threshold, overflow),
+	finished(false), accept_ranges(false), range(), byte_ranges(), slices(), part_heads(), part_marks()
+{
+	rdbuf(&buf);
+}
+
+Response::~Response() {
+	finish();
+}
+
+bool Response::finish() {
+	if (finished)
+		return !buf.error;
+	finished = true;
+	const bool ok = buf.committed ? buf.drain() : _commit(true);
+	return ok && (out == nullptr || out->rdbuf()->pubsync() == 0);
+}
+
+void Response::reset(std::ostream& out_) {
+	finish();
+	out = &out_;
+	fd = -1;
+	reset();
+}
+
+void Response::reset(int fd_) {
+	finish();
+	out = nullptr;
+	fd = fd_;
+	reset();
+}
+
+void Response::reset() {
+	finish();
+	header.clear();
+	buf.clear();
+	finished = false;
+	accept_ranges = false;
+	range.clear();
+	std::ostream::clear();
+}
+
+void Response::ranges(String_view range_) {
+	accept_ranges = true;
+	range.assign(range_.data(), range_.size());
+}
+
+/* Send the header, along with what there is of the body. A complete body has a
+ * known length; one which is committed early because it outgrew the threshold
+ * does not.
+ */
+bool Response::_commit(bool complete) {
+	const std::string* status = header.find(field::status);
+	if (complete && has_body(status)) {
+		if (accept_ranges && (status == nullptr || !status->compare(0, 3, "200")))
+			return _commit_ranges();
+		if (!header.has(field::content_length))
+			header.append(field::content_length.name, std::to_string(buf.size()));
+	} else if (complete) {
+		// A 1xx, 204 or 304 has no body, whatever was written to it
+		buf.clear();
+	}
+	head.clear();
+	header.render(head);
+	buf.committed = true;
+	return buf.write_out(false, head.data(), head.size(), nullptr, 0);
+}
+
+/* Send a complete body as its Range asks: whole, as one range, as several in a
+ * multipart/byteranges, or not at all (416). The ranges are sliced out of the
+ * pieces of the body where they are, and the part headers of a multipart body
+ * rendered into one string, so that nothing of the body is copied.
+ */
+bool Response::_commit_ranges() {
+	typedef Buffer::Piece Piece;
+	const uint64_t total = buf.size();
+	header.accept_ranges();
+	const unsigned code = range.empty() ? 0 : parse_range(range, total, byte_ranges);
+	if (code == 0) {
+		if (!header.has(field::content_length))
+			header.append(field::content_length.name, std::to_string(total));
+		head.clear();
+		header.render(head);
+		buf.committed = true;
+		return buf.write_out(false, head.data(), head.size(), nullptr, 0);
+	}
+	header.set(field::status.name, std::to_string(code) + ' '
+		+ helpers::status_helper::get_string(code));
+	std::vector<Piece>& body = buf.chunks;
+	body.clear();
+	slices.clear();
+	slices.push_back(Piece { nullptr, -1, 0, 0 });
+	if (code == 416) {
+		header.content_range(total);
+		header.set(field::content_length.name, "0");
+	} else if (byte_ranges.size() == 1) {
+		const Byte_range& r = byte_ranges[0];
+		header.content_range(r.first, r.last, total);
+		header.set(field::content_length.name, std::to_string(r.size()));
+		buf.pieces(body, true);
+		Buffer::slice(body, r.first, r.size(), slices);
+	} else {
+		// Each part header, and the closing boundary, are rendered first, so that
+		// part_heads does not move once pointed into
+		const std::string* ct = header.find(field::content_type);
+		const std::string type = (ct != nullptr) ? *ct : std::string();
+		// Responses in other threads, or in the same second, get other boundaries
+		static std::atomic<uint64_t> boundaries(0);
+		const uint64_t salt[3] = { total, reinterpret_cast<uintptr_t>(this), ++boundaries };
+		char boundary[17];
+		std::snprintf(boundary, sizeof(boundary), "%016llx", static_cast<unsigned long long>(
+			xxh64::hash(salt, sizeof(salt), std::time(nullptr))));
+		part_heads.clear();
+		std::vector<size_t>& marks = part_marks;
+		marks.clear();
+		uint64_t length = 0;
+		for (const Byte_range& r : byte_ranges) {
+			marks.push_back(part_heads.size());
+			part_heads += marks.size() == 1 ? "--" : "\r\n--";
+			part_heads += boundary;
+			part_heads += "\r\n";
+			if (!type.empty()) {
+				part_heads += field::content_type.name;
+				part_heads += ": ";
+				part_heads += type;
+				part_heads += "\r\n";
+			}
+			part_heads += field::content_range.name;
+			part_heads += ": bytes " + std::to_string(r.first) + '-' + std::to_string(r.last) + '/'
+				+ std::to_string(total) + "\r\n\r\n";
+			length += r.size();
+		}
+		marks.push_back(part_heads.size());
+		part_heads += "\r\n--";
+		part_heads += boundary;
+		part_heads += "--\r\n";
+		marks.push_back(part_heads.size());
+		length += part_heads.size();
+		header.set(field::content_type.name, std::string("multipart/byteranges; boundary=") + boundary);
+		header.set(field::content_length.name, std::to_string(length));
+		buf.pieces(body, true);
+		for (size_t i = 0; i < byte_ranges.size(); ++i) {
+			slices.push_back(Piece { part_heads.data() + marks[i], -1, 0, marks[i + 1] - marks[i] });
+			Buffer::slice(body, byte_ranges[i].first, byte_ranges[i].size(), slices);
+		}
+		const size_t last = byte_ranges.size();
+		slices.push_back(Piece { part_heads.data() + marks[last], -1, 0, marks[last + 1] - marks[last] });
+	}
+	head.clear();
+	header.render(head);
+	slices[0].data = head.data();
+	slices[0].size = head.size();
+	buf.committed = true;
+	const bool ok = buf.put(false, slices.data(), slices.size());
+	buf.consumed(false, 0);
+	if (!ok)
+		buf.error = true;
+	return ok;
+}
+
+//! Send blocks; to a file descriptor, they go in one writev()
+bool Response::_send(iovec* v, int n) {
+	if (out == nullptr)
+		return fd_io::write_all(fd, v, n);
+	std::streambuf* sb = out->rdbuf();
+	for (int i = 0; i < n; ++i) {
+		const std::streamsize k = v[i].iov_len;
+		if (k != 0 && sb->sputn(static_cast<const char*>(v[i].iov_base), k) != k)
+			return false;
+	}
+	return true;
+}
+
+bool Response::_send_file(int in, off_t offset, size_t n) {
+	return (out != nullptr) ? fd_io::send_file(out->rdbuf(), in, offset, n)
+		: fd_io::send_file(fd, in, offset, n);
+}
+
+bool Response::append(const File_body& f) {
+	// A filtered response has to have the data go through the filter
+	if (rdbuf() != &buf)
+		return rdbuf() != nullptr && fd_io::send_file(rdbuf(), f.fd, f.offset, f.size);
+	return buf.append(f);
+}
+
+bool Response::append(String_view v, std::shared_ptr<const void> keep) {
+	if (rdbuf() != &buf)
+		return rdbuf() != nullptr
+			&& rdbuf()->sputn(v.data(), v.size()) == static_cast<std::streamsize>(v.size());
+	return buf.append(v, std::move(keep));
+}
+
+Response::Buffer::Buffer(Response& r_, size_t threshold_, unsigned overflow_)
+: r(r_), threshold(threshold_), overflow_mode(overflow_), store(), parts(), parts_size(0), chunks(), iov(), sent(0),
+	file(-1), spilled(0), committed(false), error(false)
+{
+	setp(nullptr, nullptr);
+}
+
+Response::Buffer::~Buffer() {
+	if (file >= 0)
+		::close(file);
+}
+
+size_t Response::Buffer::size() const {
+	return sent + spilled + (pptr() - pbase()) + parts_size;
+}
+
+void Response::Buffer::clear() {
+	sent = 0;
+	committed = false;
+	error = false;
+	parts.clear();
+	parts_size = 0;
+	// The file is kept for the next response to spill to, but not its contents
+	if (file >= 0 && (::ftruncate(file, 0) != 0 || ::lseek(file, 0, SEEK_SET) != 0)) {
+		::close(file);
+		file = -1;
+	}
+	spilled = 0;
+	char* b = store.empty() ? nullptr : &store[0];
+	setp(b, b + store.size());
+}
+
+//! List the pieces of the body: what is in the spill file, then the buffer and parts
+void Response::Buffer::pieces(std::vector<Piece>& v, bool with_spilled) const {
+	if (with_spilled && spilled != 0)
+		v.push_back(Piece { nullptr, file, 0, spilled });
+	size_t at = 0;
+	for (const Part& p : parts) {
+		if (p.at != at)
+			v.push_back(Piece { pbase() + at, -1, 0, p.at - at });
+		v.push_back(p.piece);
+		at = p.at;
+	}
+	const size_t used = pptr() - pbase();
+	if (used != at)
+		v.push_back(Piece { pbase() + at, -1, 0, used - at });
+}
+
+//! Add the pieces of bytes [first, first + n) of v to out
+void Response::Buffer::slice(const std::vector<Piece>& v, uint64_t first, uint64_t n,
+		std::vector<Piece>& out)
+{
+	uint64_t at = 0;
+	for (const Piece& p : v) {
+		if (n == 0)
+			break;
+		if (first < at + p.size) {
+			const size_t skip = first - at;
+			const size_t k = (p.size - skip < n) ? p.size - skip : n;
+			out.push_back(Piece { (p.data != nullptr) ? p.data + skip : nullptr, p.fd,
+				p.offset + static_cast<off_t>(skip), k });
+			first += k;
+			n -= k;
+		}
+		at += p.size;
+	}
+}
+
+/* Write pieces out, to the spill file or the destination. Pieces in memory are
+ * gathered, to go out in one writev() up to the next piece in a file.
+ */
+bool Response::Buffer::put(bool to_file, const Piece* p, size_t n) {
+	auto flush = [this, to_file]() {
+		const int k = iov.size();
+		const bool ok = k == 0 || (to_file ? fd_io::write_all(file, iov.data(), k)
+			: r._send(iov.data(), k));
+		iov.clear();
+		return ok;
+	};
+	iov.clear();
+	bool ok = true;
+	for (const Piece* e = p + n; p != e; ++p) {
+		if (p->size == 0)
+			continue;
+		if (p->data != nullptr)
+			iov.push_back(iovec { const_cast<char*>(p->data), p->size });
+		else
+			ok = ok && flush() && (to_file ? fd_io::send_file(file, p->fd, p->offset, p->size)
+				: r._send_file(p->fd, p->offset, p->size));
+		if (iov.size() >= max_blocks)
+			ok = ok && flush();
+	}
+	return ok && flush();
+}
+
+//! Count the body, and n more bytes, as spilled or sent, and empty the buffer
+void Response::Buffer::consumed(bool to_file, size_t n) {
+	const size_t k = (pptr() - pbase()) + parts_size + n;
+	if (to_file) {
+		spilled += k;
+	} else {
+		sent += spilled + k;
+		spilled = 0;
+	}
+	parts.clear();
+	parts_size = 0;
+	setp(pbase(), epptr());
+}
+
+/* Write the body out, between a header block and n more bytes of body; to the
+ * spill file, or to the destination, in which case it includes the spill file.
+ */
+bool Response::Buffer::write_out(bool to_file, const char* h, size_t hn, const char* s, size_t n) {
+	if (error)
+		return false;
+	chunks.clear();
+	chunks.push_back(Piece { h, -1, 0, hn });
+	pieces(chunks, !to_file);
+	chunks.push_back(Piece { s, -1, 0, n });
+	if (!put(to_file, chunks.data(), chunks.size()))
+		error = true;
+	consumed(to_file, n);
+	return !error;
+}
+
+//! Send the buffered part of a committed body, and n more bytes
+bool Response::Buffer::drain(const char* s, size_t n) {
+	return write_out(false, nullptr, 0, s, n);
+}
+
+/* Move the buffer, and n more bytes, to the spill file. Fails without writing
+ * anything if there is no file and none can be made.
+ */
+bool Response::Buffer::_spill(const char* s, size_t n) {
+	if (file < 0 && (file = fd_io::temp_file()) < 0)
+		return false;
+	write_out(true, nullptr, 0, s, n);
+	return true;
+}
+
+//! Add a file part: sent now if committed, else kept in its place in the buffer
+bool Response::Buffer::append(const File_body& f) {
+	if (error)
+		return false;
+	if (committed) {
+		if (!drain())
+			return false;
+		if (!r._send_file(f.fd, f.offset, f.size))
+			error = true;
+		sent += f.size;
+		return !error;
+	}
+	parts.push_back(Part { static_cast<size_t>(pptr() - pbase()), Piece { nullptr, f.fd, f.offset, f.size },
+		nullptr });
+	parts_size += f.size;
+	return true;
+}
+
+//! Add data kept by its owner: sent now if committed, else kept in its place in the buffer
+bool Response::Buffer::append(String_view v, std::shared_ptr<const void>&& keep) {
+	if (error)
+		return false;
+	if (committed)
+		return drain(v.data(), v.size());
+	parts.push_back(Part { static_cast<size_t>(pptr() - pbase()), Piece { v.data(), -1, 0, v.size() },
+		std::move(keep) });
+	parts_size += v.size();
+	return true;
+}
+
+/* Make room for n more bytes: grow the buffer while below the threshold, and
+ * once past it, spill it or commit and drain it.
+ */
+bool Response::Buffer::_make_room(size_t n) {
+	if (error)
+		return false;
+	const size_t used = pptr() - pbase();
+	if (!committed && used + n > threshold) {
+		// Without a file to spill to, the body is streamed after all
+		if (overflow_mode != Overflow::spill || !_spill(nullptr, 0))
+			return r._commit(false) && _make_room(n);
+		if (store.empty()) {
+			store.resize(4096);
+			setp(&store[0], &store[0] + store.size());
+		}
+		return !error;
+	}
+	if (committed) {
+		if (!drain())
+			return false;
+		if (store.empty()) {
+			store.resize(4096);
+			setp(&store[0], &store[0] + store.size());
+		}
+		return true;
+	}
+	size_t cap = store.empty() ? 4096 : store.size() * 2;
+	while (cap < used + n)
+		cap *= 2;
+	if (cap > threshold)
+		cap = threshold;
+	store.resize(cap);
+	setp(&store[0], &store[0] + cap);
+	_bump(used);
+	return true;
+}
+
+//! pbump() takes an int
+void Response::Buffer::_bump(size_t n) {
+	for (; n > INT_MAX; n -= INT_MAX)
+		pbump(INT_MAX);
+	pbump(static_cast<int>(n));
+}
+
+Response::Buffer::int_type Response::Buffer::overflow(int_type c) {
+	if (!_make_room(1))
+		return traits_type::eof();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+std::streamsize Response::Buffer::xsputn(const char* s, std::streamsize n) {
+	std::streamsize written = 0;
+	while (written < n) {
+		const size_t left = n - written;
+		// Once streaming, a write larger than the buffer goes straight out
+		if (committed && left >= store.size()) {
+			if (drain(s + written, left))
+				written = n;
+			break;
+		}
+		// and once spilling, straight to the file
+		if (spilled != 0 && left >= store.size() && _spill(s + written, left)) {
+			if (!error)
+				written = n;
+			break;
+		}
+		const size_t room = epptr() - pptr();
+		if (room == 0) {
+			if (!_make_room(left))
+				break;
+			continue;
+		}
+		const size_t k = (left < room) ? left : room;
+		std::memcpy(pptr(), s + written, k);
+		_bump(k);
+		written += k;
+	}
+	return written;
+}
+
+int Response::Buffer::sync() {
+	// A flush does not commit the response; once committed, it passes through
+	if (!committed)
+		return 0;
+	return (drain() && (r.out == nullptr || r.out->rdbuf()->pubsync() == 0)) ? 0 : -1;
+}
+
+}
+
+MOSH_CGI_END
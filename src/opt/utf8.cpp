@@ -0,0 +1,298 @@
+//! @file opt/utf8.cpp UTF-8 validation, repair and encoding
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <mosh/cgi/bits/utf8.hpp>
+#include <mosh/cgi/bits/cpu.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+#ifdef MOSH_CGI_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using namespace MOSH_CGI;
+
+typedef const char* (*skip_ascii_fn)(const char*, const char*);
+typedef size_t (*narrow_ascii_fn)(char*, const wchar_t*, size_t);
+
+inline uint8_t u8(char c) {
+	return static_cast<uint8_t>(c);
+}
+
+//! Skip ASCII, a word at a time
+const char* skip_ascii_generic(const char* p, const char* e) {
+	for (; e - p >= 8; p += 8) {
+		uint64_t w;
+		std::memcpy(&w, p, 8);
+		if (w & 0x8080808080808080ull)
+			break;
+	}
+	while (p != e && u8(*p) < 0x80)
+		++p;
+	return p;
+}
+
+#ifdef MOSH_CGI_X86_KERNELS
+MOSH_CGI_TARGET("sse2")
+const char* skip_ascii_sse2(const char* p, const char* e) {
+	for (; e - p >= 16; p += 16) {
+		const int m = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+		if (m != 0)
+			return p + __builtin_ctz(m);
+	}
+	return skip_ascii_generic(p, e);
+}
+
+MOSH_CGI_TARGET("avx2")
+const char* skip_ascii_avx2(const char* p, const char* e) {
+	for (; e - p >= 32; p += 32) {
+		const int m = _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+		if (m != 0)
+			return p + __builtin_ctz(m);
+	}
+	return skip_ascii_generic(p, e);
+}
+#else
+const skip_ascii_fn skip_ascii_sse2 = nullptr;
+const skip_ascii_fn skip_ascii_avx2 = nullptr;
+#endif
+
+skip_ascii_fn skip_ascii() {
+	static const skip_ascii_fn f = cpu::select<skip_ascii_fn>(skip_ascii_generic, skip_ascii_sse2,
+		skip_ascii_avx2);
+	return f;
+}
+
+/* Check the sequence starting at p. Return its length if it is valid, 0 if it
+ * is valid so far but cut short by e, or minus the length of its maximal
+ * invalid subpart.
+ */
+int check_sequence(const char* p, const char* e) {
+	const uint8_t b = u8(*p);
+	uint8_t lo = 0x80, hi = 0xBF;
+	int n;
+	if (b < 0x80)
+		return 1;
+	else if (b < 0xC2)
+		return -1;
+	else if (b < 0xE0)
+		n = 2;
+	else if (b < 0xF0) {
+		n = 3;
+		if (b == 0xE0)
+			lo = 0xA0;	// overlong
+		else if (b == 0xED)
+			hi = 0x9F;	// surrogates
+	} else if (b < 0xF5) {
+		n = 4;
+		if (b == 0xF0)
+			lo = 0x90;	// overlong
+		else if (b == 0xF4)
+			hi = 0x8F;	// above U+10FFFF
+	} else
+		return -1;
+	for (int i = 1; i < n; ++i) {
+		if (p + i == e)
+			return 0;
+		const uint8_t c = u8(p[i]);
+		if (c < lo || c > hi)
+			return -i;
+		lo = 0x80;
+		hi = 0xBF;
+	}
+	return n;
+}
+
+//! Encode one code point, or U+FFFD if it is not a scalar value; return the length
+size_t encode(char* b, unsigned long cp) {
+	if (cp >= 0xD800 && (cp < 0xE000 || cp > 0x10FFFF))
+		cp = 0xFFFD;
+	if (cp < 0x80) {
+		b[0] = static_cast<char>(cp);
+		return 1;
+	} else if (cp < 0x800) {
+		b[0] = static_cast<char>(0xC0 | (cp >> 6));
+		b[1] = static_cast<char>(0x80 | (cp & 0x3F));
+		return 2;
+	} else if (cp < 0x10000) {
+		b[0] = static_cast<char>(0xE0 | (cp >> 12));
+		b[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		b[2] = static_cast<char>(0x80 | (cp & 0x3F));
+		return 3;
+	}
+	b[0] = static_cast<char>(0xF0 | (cp >> 18));
+	b[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+	b[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+	b[3] = static_cast<char>(0x80 | (cp & 0x3F));
+	return 4;
+}
+
+inline unsigned long code_unit(wchar_t c) {
+	return static_cast<unsigned long>(c) & ((sizeof(wchar_t) == 2) ? 0xFFFFul : 0xFFFFFFFFul);
+}
+
+/* Copy the leading ASCII of a wide string, narrowed, and return its length.
+ * The vector versions handle a 32-bit wchar_t, and stop at the first block
+ * which is not all ASCII; the caller finishes character by character.
+ */
+size_t narrow_ascii_generic(char* o, const wchar_t* p, size_t n) {
+	size_t i = 0;
+	for (; n - i >= 4; i += 4) {
+		if (code_unit(p[i] | p[i + 1] | p[i + 2] | p[i + 3]) >= 0x80)
+			break;
+		o[i] = static_cast<char>(p[i]);
+		o[i + 1] = static_cast<char>(p[i + 1]);
+		o[i + 2] = static_cast<char>(p[i + 2]);
+		o[i + 3] = static_cast<char>(p[i + 3]);
+	}
+	return i;
+}
+
+#ifdef MOSH_CGI_X86_KERNELS
+MOSH_CGI_TARGET("sse2")
+size_t narrow_ascii_sse2(char* o, const wchar_t* p, size_t n) {
+	const __m128i high = _mm_set1_epi32(~0x7F);
+	size_t i = 0;
+	for (; n - i >= 16; i += 16) {
+		const __m128i* v = reinterpret_cast<const __m128i*>(p + i);
+		const __m128i a = _mm_loadu_si128(v), b = _mm_loadu_si128(v + 1);
+		const __m128i c = _mm_loadu_si128(v + 2), d = _mm_loadu_si128(v + 3);
+		const __m128i any = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), high);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(any, _mm_setzero_si128())) != 0xFFFF)
+			break;
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(o + i),
+			_mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+	}
+	return i + narrow_ascii_generic(o + i, p + i, n - i);
+}
+
+MOSH_CGI_TARGET("avx2")
+size_t narrow_ascii_avx2(char* o, const wchar_t* p, size_t n) {
+	const __m256i high = _mm256_set1_epi32(~0x7F);
+	// packs and packus work within 128-bit lanes; this puts the dwords back in order
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	size_t i = 0;
+	for (; n - i >= 32; i += 32) {
+		const __m256i* v = reinterpret_cast<const __m256i*>(p + i);
+		const __m256i a = _mm256_loadu_si256(v), b = _mm256_loadu_si256(v + 1);
+		const __m256i c = _mm256_loadu_si256(v + 2), d = _mm256_loadu_si256(v + 3);
+		const __m256i any = _mm256_and_si256(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d)),
+			high);
+		if (!_mm256_testz_si256(any, any))
+			break;
+		const __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(o + i), _mm256_permutevar8x32_epi32(bytes, order));
+	}
+	return i + narrow_ascii_sse2(o + i, p + i, n - i);
+}
+#else
+const narrow_ascii_fn narrow_ascii_sse2 = nullptr;
+const narrow_ascii_fn narrow_ascii_avx2 = nullptr;
+#endif
+
+narrow_ascii_fn narrow_ascii() {
+	if (sizeof(wchar_t) != 4)
+		return narrow_ascii_generic;
+	static const narrow_ascii_fn f = cpu::select<narrow_ascii_fn>(narrow_ascii_generic,
+		narrow_ascii_sse2, narrow_ascii_avx2);
+	return f;
+}
+
+}
+
+MOSH_CGI_BEGIN
+namespace utf8 {
+
+size_t valid_prefix(const char* s, size_t n) {
+	const skip_ascii_fn skip = skip_ascii();
+	const char* p = s;
+	const char* const e = s + n;
+	for (;;) {
+		p = skip(p, e);
+		if (p == e)
+			break;
+		const int k = check_sequence(p, e);
+		if (k <= 0)
+			break;
+		p += k;
+	}
+	return p - s;
+}
+
+bool truncated(const char* s, size_t n) {
+	return n != 0 && check_sequence(s, s + n) == 0;
+}
+
+size_t repair(std::string& out, const char* s, size_t n, bool final) {
+	const char* p = s;
+	const char* const e = s + n;
+	while (p != e) {
+		const size_t v = valid_prefix(p, e - p);
+		out.append(p, v);
+		p += v;
+		if (p == e)
+			break;
+		const int k = check_sequence(p, e);
+		if (k == 0 && !final)
+			break;
+		out.append(replacement, sizeof(replacement) - 1);
+		p += (k == 0) ? (e - p) : -k;
+	}
+	return p - s;
+}
+
+void append(std::string& out, const wchar_t* s, size_t n) {
+	const narrow_ascii_fn narrow = narrow_ascii();
+	const wchar_t* p = s;
+	const wchar_t* const e = s + n;
+	size_t pos = out.size();
+	/* Every character takes at least a byte, so ASCII is narrowed in place. Room
+	 * for the rest of the input, a byte per character, is kept after pos; it is
+	 * grown when a character takes more.
+	 */
+	out.resize(pos + n);
+	while (p != e) {
+		const size_t k = narrow(&out[pos], p, e - p);
+		pos += k;
+		p += k;
+		if (p == e)
+			break;
+		const size_t need = pos + (e - p) + 3;
+		if (out.size() < need)
+			out.resize((need > out.size() + out.size() / 2) ? need : out.size() + out.size() / 2);
+		unsigned long cp = code_unit(*p++);
+		if (sizeof(wchar_t) == 2 && cp >= 0xD800 && cp < 0xDC00 && p != e) {
+			const unsigned long lo = code_unit(*p);
+			if (lo >= 0xDC00 && lo < 0xE000) {
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+				++p;
+			}
+		}
+		pos += encode(&out[pos], cp);
+	}
+	out.resize(pos);
+}
+
+}
+MOSH_CGI_END
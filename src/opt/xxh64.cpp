@@ -0,0 +1,137 @@
+//! @file opt/xxh64.cpp 64-bit non-cryptographic hash
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mosh/cgi/bits/xxh64.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+namespace {
+
+const uint64_t p1 = 11400714785074694791ULL;
+const uint64_t p2 = 14029467366897019727ULL;
+const uint64_t p3 = 1609587929392839161ULL;
+const uint64_t p4 = 9650029242287828579ULL;
+const uint64_t p5 = 2870177450012600261ULL;
+
+inline uint64_t rotl(uint64_t x, unsigned r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+// Little-endian loads, as the reference defines the hash
+inline uint64_t read64(const unsigned char* p) {
+	return uint64_t(p[0]) | uint64_t(p[1]) << 8 | uint64_t(p[2]) << 16 | uint64_t(p[3]) << 24
+		| uint64_t(p[4]) << 32 | uint64_t(p[5]) << 40 | uint64_t(p[6]) << 48 | uint64_t(p[7]) << 56;
+}
+
+inline uint64_t read32(const unsigned char* p) {
+	return uint64_t(p[0]) | uint64_t(p[1]) << 8 | uint64_t(p[2]) << 16 | uint64_t(p[3]) << 24;
+}
+
+inline uint64_t lane(uint64_t acc, uint64_t input) {
+	return rotl(acc + input * p2, 31) * p1;
+}
+
+inline uint64_t merge(uint64_t acc, uint64_t v) {
+	return (acc ^ lane(0, v)) * p1 + p4;
+}
+
+//! Consume whole stripes; returns the number of bytes consumed
+size_t stripes(uint64_t* v, const unsigned char* p, size_t n) {
+	const unsigned char* const b = p;
+	for (; n >= 32; p += 32, n -= 32) {
+		v[0] = lane(v[0], read64(p));
+		v[1] = lane(v[1], read64(p + 8));
+		v[2] = lane(v[2], read64(p + 16));
+		v[3] = lane(v[3], read64(p + 24));
+	}
+	return p - b;
+}
+
+uint64_t finish(const uint64_t* v, uint64_t seed, uint64_t total, const unsigned char* p, size_t n) {
+	uint64_t h;
+	if (total >= 32) {
+		h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18);
+		for (unsigned i = 0; i < 4; ++i)
+			h = merge(h, v[i]);
+	} else {
+		h = seed + p5;
+	}
+	h += total;
+	for (; n >= 8; p += 8, n -= 8)
+		h = rotl(h ^ lane(0, read64(p)), 27) * p1 + p4;
+	if (n >= 4) {
+		h = rotl(h ^ (read32(p) * p1), 23) * p2 + p3;
+		p += 4;
+		n -= 4;
+	}
+	for (; n != 0; ++p, --n)
+		h = rotl(h ^ (*p * p5), 11) * p1;
+	h ^= h >> 33;
+	h *= p2;
+	h ^= h >> 29;
+	h *= p3;
+	h ^= h >> 32;
+	return h;
+}
+
+}
+
+MOSH_CGI_BEGIN
+
+namespace xxh64 {
+
+uint64_t hash(const void* p, size_t n, uint64_t seed) {
+	uint64_t v[4] = { seed + p1 + p2, seed + p2, seed, seed - p1 };
+	const unsigned char* b = static_cast<const unsigned char*>(p);
+	const size_t k = stripes(v, b, n);
+	return finish(v, seed, n, b + k, n - k);
+}
+
+State::State(uint64_t seed_)
+: v { seed_ + p1 + p2, seed_ + p2, seed_, seed_ - p1 }, seed(seed_), total(0), n_tail(0)
+{ }
+
+void State::update(const void* p, size_t n) {
+	const unsigned char* b = static_cast<const unsigned char*>(p);
+	total += n;
+	if (n_tail != 0) {
+		const size_t k = (n < 32 - n_tail) ? n : 32 - n_tail;
+		std::memcpy(tail + n_tail, b, k);
+		n_tail += k;
+		b += k;
+		n -= k;
+		if (n_tail < 32)
+			return;
+		stripes(v, tail, 32);
+		n_tail = 0;
+	}
+	const size_t k = stripes(v, b, n);
+	std::memcpy(tail, b + k, n - k);
+	n_tail = n - k;
+}
+
+uint64_t State::digest() const {
+	return finish(v, seed, total, tail, n_tail);
+}
+
+}
+
+MOSH_CGI_END
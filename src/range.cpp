@@ -0,0 +1,142 @@
+//! @file range.cpp Byte range requests
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <mosh/cgi/http/range.hpp>
+#include <mosh/cgi/http/field_map.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+namespace {
+
+//! Cursor over a Range field
+struct Range_reader {
+	const char* p;
+	const char* e;
+
+	void skip_ows() {
+		while (p != e && (*p == ' ' || *p == '\t'))
+			++p;
+	}
+
+	bool lit(char c) {
+		if (p == e || *p != c)
+			return false;
+		++p;
+		return true;
+	}
+
+	//! A decimal number; fails on overflow
+	bool num(uint64_t& n) {
+		if (p == e || *p < '0' || *p > '9')
+			return false;
+		n = 0;
+		for (; p != e && *p >= '0' && *p <= '9'; ++p) {
+			const uint64_t d = *p - '0';
+			if (n > (UINT64_MAX - d) / 10)
+				return false;
+			n = n * 10 + d;
+		}
+		return true;
+	}
+};
+
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+/*! @brief Parse a Range field
+ *  @param[in] value field value, e.g. "bytes=0-499,-500"
+ *  @param[in] length length of the representation
+ *  @param[out] ranges the satisfiable ranges
+ *  @return 206, 416, or 0 if the field is to be ignored
+ */
+unsigned parse_range(String_view value, uint64_t length, std::vector<Byte_range>& ranges) {
+	ranges.clear();
+	auto ignore = [&ranges]() {
+		ranges.clear();
+		return 0u;
+	};
+	Range_reader r { value.begin(), value.end() };
+	r.skip_ows();
+	if (r.e - r.p < 5 || !field_equal(r.p, 5, "bytes", 5))
+		return 0;
+	r.p += 5;
+	r.skip_ows();
+	if (!r.lit('='))
+		return 0;
+	size_t specs = 0;
+	for (;;) {
+		r.skip_ows();
+		if (r.p == r.e)
+			break;
+		if (r.lit(','))
+			continue;
+		uint64_t first, last;
+		if (r.lit('-')) {
+			// The last n bytes
+			uint64_t n;
+			if (!r.num(n))
+				return ignore();
+			if (n != 0 && length != 0) {
+				first = (n < length) ? length - n : 0;
+				ranges.push_back(Byte_range { first, length - 1 });
+			}
+		} else {
+			if (!r.num(first) || !r.lit('-'))
+				return ignore();
+			last = UINT64_MAX;
+			if (r.p != r.e && *r.p >= '0' && *r.p <= '9') {
+				if (!r.num(last) || last < first)
+					return ignore();
+			}
+			if (first < length)
+				ranges.push_back(Byte_range { first, std::min(last, length - 1) });
+		}
+		if (++specs > max_ranges)
+			return ignore();
+		r.skip_ows();
+		if (r.p != r.e && !r.lit(','))
+			return ignore();
+	}
+	if (specs == 0)
+		return 0;
+	if (ranges.empty())
+		return 416;
+	std::sort(ranges.begin(), ranges.end(),
+		[](const Byte_range& a, const Byte_range& b) { return a.first < b.first; });
+	size_t k = 0;
+	for (size_t i = 1; i < ranges.size(); ++i) {
+		if (ranges[i].first <= ranges[k].last + 1)
+			ranges[k].last = std::max(ranges[k].last, ranges[i].last);
+		else
+			ranges[++k] = ranges[i];
+	}
+	ranges.resize(k + 1);
+	return 206;
+}
+
+}
+
+MOSH_CGI_END
@@ -0,0 +1,159 @@
+//! @file tag_registry.cpp Runtime lookup of HTML elements by name
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <mosh/cgi/html/element.hpp>
+#include <mosh/cgi/html/element/registry.hpp>
+#include <mosh/cgi/html/html_doctype.hpp>
+#include <mosh/cgi/bits/indices.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+MOSH_CGI_BEGIN
+namespace html {
+namespace element {
+namespace registry {
+
+namespace {
+
+using namespace dtd;
+
+constexpr Tag tags[] = {
+#define MOSH_CGI_HTML_TAG(name_, type_, dtds_) \
+	{ #name_, sizeof(#name_) - 1, Type::type_, dtds_, \
+	  "<" #name_, sizeof(#name_), "</" #name_ ">", sizeof(#name_) + 2 },
+#include <mosh/cgi/html/element/tags.def>
+#undef MOSH_CGI_HTML_TAG
+};
+
+constexpr size_t n_tags = sizeof(tags) / sizeof(tags[0]);
+
+/* The perfect hash is FNV-1a with a non-standard offset basis, folded down to
+ * n_slots. The seed was picked by search so that no two names share a slot; the
+ * static_assert below catches any addition to tags.def which breaks that, in
+ * which case a new seed has to be found.
+ */
+constexpr uint32_t seed = 387833u;
+constexpr size_t n_slots = 512;
+constexpr uint8_t no_tag = 0xFF;
+
+static_assert(n_tags < no_tag, "too many tags for an 8-bit slot table");
+
+constexpr uint32_t hash(const char* s, uint32_t h = seed) {
+	return *s ? hash(s + 1, (h ^ static_cast<unsigned char>(*s)) * 16777619u) : h;
+}
+
+constexpr size_t slot_of(uint32_t h) {
+	return (h ^ (h >> 15)) & (n_slots - 1);
+}
+
+constexpr size_t tag_slots[] = {
+#define MOSH_CGI_HTML_TAG(name_, type_, dtds_) slot_of(hash(#name_)),
+#include <mosh/cgi/html/element/tags.def>
+#undef MOSH_CGI_HTML_TAG
+};
+
+//! Index of the first tag hashing to slot s
+constexpr uint8_t tag_in_slot(size_t s, size_t i = 0) {
+	return (i == n_tags) ? no_tag : (tag_slots[i] == s) ? static_cast<uint8_t>(i) : tag_in_slot(s, i + 1);
+}
+
+constexpr bool collision_free(size_t i = 0) {
+	return (i == n_tags) || (tag_in_slot(tag_slots[i]) == i && collision_free(i + 1));
+}
+
+static_assert(collision_free(), "tag hash is no longer perfect; pick another seed");
+
+struct Slot_table {
+	uint8_t tag[n_slots];
+};
+
+template <size_t... I>
+constexpr Slot_table make_slot_table(Indices<I...>) {
+	return Slot_table {{ tag_in_slot(I)... }};
+}
+
+constexpr Slot_table slot_table = make_slot_table(Make_indices<n_slots>::type());
+
+}
+
+namespace dtd {
+
+/*! @brief Get the DTD family of an HTML revision
+ *  @param[in] hr HTML revision
+ *  @throw std::invalid_argument if hr is not a known revision
+ */
+unsigned from_revision(unsigned hr) {
+	namespace rev = html_doctype::html_revision;
+	switch (hr) {
+	case rev::html_4_strict:
+	case rev::xhtml_10_strict:
+		return strict;
+	case rev::html_4_transitional:
+	case rev::xhtml_10_transitional:
+		return transitional;
+	case rev::html_4_frameset:
+	case rev::xhtml_10_frameset:
+		return frameset;
+	case rev::xhtml_11:
+	case rev::xhtml_basic_10:
+	case rev::xhtml_basic_11:
+	case rev::xhtml_mp_10:
+	case rev::xhtml_mp_11:
+	case rev::xhtml_mp_12:
+		return xhtml_11;
+	case rev::html_5:
+		return html_5;
+	default:;
+	}
+	throw std::invalid_argument("doctype not found");
+}
+
+}
+
+/*! @brief Find a tag by name
+ *  @param[in] name element name
+ *  @param[in] n length of name
+ *  @return the tag descriptor, or a null pointer if the name is unknown
+ */
+const Tag* find(const char* name, size_t n) {
+	uint32_t h = seed;
+	for (size_t i = 0; i < n; ++i)
+		h = (h ^ static_cast<unsigned char>(name[i])) * 16777619u;
+	uint8_t i = slot_table.tag[slot_of(h)];
+	if (i == no_tag)
+		return nullptr;
+	const Tag& t = tags[i];
+	return (t.size == n && !std::memcmp(t.name, name, n)) ? &t : nullptr;
+}
+
+const Tag* begin() {
+	return tags;
+}
+
+const Tag* end() {
+	return tags + n_tags;
+}
+
+}
+}
+}
+MOSH_CGI_END
@@ -0,0 +1,182 @@
+//! @file utf8_filter.cpp UTF-8 checking output stage
+/*
+ *  Copyright (C) 2011 m0shbear
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <mosh/cgi/http/utf8_filter.hpp>
+#include <mosh/cgi/bits/utf8.hpp>
+#include <mosh/cgi/bits/string_view.hpp>
+#include <mosh/cgi/bits/namespace.hpp>
+
+namespace {
+
+using MOSH_CGI::String_view;
+
+inline char lower(char c) {
+	return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+bool lower_equals(String_view s, const char* name) {
+	size_t i = 0;
+	for (; i < s.size() && name[i]; ++i) {
+		if (lower(s[i]) != name[i])
+			return false;
+	}
+	return i == s.size() && !name[i];
+}
+
+}
+
+MOSH_CGI_BEGIN
+
+namespace http {
+
+String_view charset_of(String_view ct) {
+	static const char key[] = "charset=";
+	const size_t kn = sizeof(key) - 1;
+	for (size_t i = 0; i + kn <= ct.size(); ++i) {
+		if (!lower_equals(String_view(ct.data() + i, kn), key))
+			continue;
+		size_t b = i + kn;
+		size_t e = b;
+		if (b < ct.size() && ct[b] == '"') {
+			e = ++b;
+			while (e < ct.size() && ct[e] != '"')
+				++e;
+		} else {
+			while (e < ct.size() && ct[e] != ';' && ct[e] != ' ' && ct[e] != '\t'
+					&& ct[e] != '\r' && ct[e] != '\n')
+				++e;
+		}
+		return String_view(ct.data() + b, e - b);
+	}
+	return String_view();
+}
+
+bool is_utf8_charset(String_view cs) {
+	String_view p = charset_of(cs);
+	if (p.data() != nullptr)
+		cs = p;
+	return lower_equals(cs, "utf-8") || lower_equals(cs, "utf8");
+}
+
+Utf8_filter::Utf8_filter(std::streambuf* dest_, unsigned mode_)
+: dest(dest_), mode(mode_), failed(false), error(false), fixed()
+{
+	setp(buf, buf + sizeof(buf));
+}
+
+Utf8_filter::~Utf8_filter() {
+	finish();
+}
+
+bool Utf8_filter::finish() {
+	return _drain(true) && dest->pubsync() == 0;
+}
+
+Utf8_filter::int_type Utf8_filter::overflow(int_type c) {
+	if (!_drain(false))
+		return traits_type::eof();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+std::streamsize Utf8_filter::xsputn(const char* s, std::streamsize n) {
+	std::streamsize done = 0;
+	while (done < n) {
+		std::streamsize room = epptr() - pptr();
+		if (room == 0) {
+			if (!_drain(false))
+				break;
+			continue;
+		}
+		const std::streamsize k = (n - done < room) ? n - done : room;
+		std::memcpy(pptr(), s + done, k);
+		pbump(static_cast<int>(k));
+		done += k;
+	}
+	return done;
+}
+
+int Utf8_filter::sync() {
+	return (_drain(false) && dest->pubsync() == 0) ? 0 : -1;
+}
+
+bool Utf8_filter::_write(const char* s, size_t n) {
+	if (n != 0 && dest->sputn(s, n) != static_cast<std::streamsize>(n))
+		error = true;
+	return !error;
+}
+
+/* Pass the buffer on. Whatever is left unwritten (a sequence cut short by the end
+ * of the buffer, at most 3 bytes) moves to the front of the buffer.
+ */
+bool Utf8_filter::_drain(bool final) {
+	if (failed || error)
+		return false;
+	const char* const b = pbase();
+	const size_t n = pptr() - b;
+	const size_t v = utf8::valid_prefix(b, n);
+	if (!_write(b, v))
+		return false;
+	size_t done = v;
+	if (v != n) {
+		if (mode == Utf8_check::repair) {
+			fixed.clear();
+			done += utf8::repair(fixed, b + v, n - v, final);
+			if (!_write(fixed.data(), fixed.size()))
+				return false;
+		} else if (final || !utf8::truncated(b + v, n - v)) {
+			failed = true;
+			return false;
+		}
+	}
+	const size_t rest = n - done;
+	std::memmove(buf, b + done, rest);
+	setp(buf, buf + sizeof(buf));
+	pbump(static_cast<int>(rest));
+	return true;
+}
+
+Utf8_output::Utf8_output(std::ostream& os_, String_view charset, unsigned mode)
+: os(os_), filter(), saved(nullptr)
+{
+	if (is_utf8_charset(charset)) {
+		filter.reset(new Utf8_filter(os.rdbuf(), mode));
+		saved = os.rdbuf(filter.get());
+	}
+}
+
+Utf8_output::~Utf8_output() {
+	if (filter != nullptr) {
+		os.flush();
+		filter->finish();
+		os.rdbuf(saved);
+	}
+}
+
+}
+
+MOSH_CGI_END